@@ -0,0 +1,297 @@
+#pragma once
+
+#include "TCPBuf.h"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <ios>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace Network
+{
+
+namespace Detail
+{
+
+template<typename T>
+inline constexpr bool IsSpan = false;
+template<typename T, std::size_t N>
+inline constexpr bool IsSpan<std::span<T, N>> = true;
+
+} // namespace Detail
+
+// 会按指定字节序写出的标量：整数、枚举，以及4或8字节的浮点数。long double
+// 的大小和格式因平台而异（x86-64上是80位扩展精度补齐到16字节），没法可移植
+// 地交换字节序，因此不支持。
+template<typename T>
+concept BinaryScalar =
+    std::is_integral_v<T> || std::is_enum_v<T> ||
+    (std::is_floating_point_v<T> && (sizeof(T) == 4 || sizeof(T) == 8));
+
+// 按位拷贝即可序列化的类型。标量按指定字节序写出；其他平凡可复制类型（如POD
+// 结构体）按对象表示原样写出，两端需保证布局一致。
+// 指针和span虽然平凡可复制，但写出地址没有意义，因此排除；不支持的浮点数也排除。
+template<typename T>
+concept BinarySerializable =
+    std::is_trivially_copyable_v<T> && !std::is_pointer_v<T> &&
+    !Detail::IsSpan<T> && (!std::is_floating_point_v<T> || BinaryScalar<T>);
+
+namespace Detail
+{
+
+template<typename T>
+constexpr bool NeedByteSwap(std::endian endian) noexcept
+{
+    if constexpr (BinaryScalar<T> && sizeof(T) > 1)
+        return endian != std::endian::native;
+    else
+        return false;
+}
+
+template<BinaryScalar T>
+T ByteSwap(T value) noexcept
+{
+    if constexpr (std::is_enum_v<T>)
+    {
+        return static_cast<T>(ByteSwap(std::to_underlying(value)));
+    }
+    else if constexpr (std::is_floating_point_v<T>)
+    {
+        using Bits = std::conditional_t<sizeof(T) == 4, std::uint32_t,
+                                        std::uint64_t>;
+        static_assert(sizeof(T) == sizeof(Bits));
+        return std::bit_cast<T>(std::byteswap(std::bit_cast<Bits>(value)));
+    }
+    else
+    {
+        return std::byteswap(value);
+    }
+}
+
+} // namespace Detail
+
+// 把值以二进制写进TCPBuf的put区，不经过文本格式化。字节序与本机一致时
+// 直接memcpy（数组也是一次拷贝）；否则边交换边写进put区，不需要临时缓冲。
+// 出错时给关联的流设置badbit，错误码仍从TCPBuf::GetError获取。
+class BinaryWriter
+{
+public:
+    template<typename Stream>
+    explicit BinaryWriter(Stream &stream,
+                          std::endian endian = std::endian::little)
+        : buf_{ *stream.rdbuf() }, state_{ stream }, endian_{ endian }
+    {
+    }
+
+    template<BinarySerializable T>
+    BinaryWriter &Write(const T &value)
+    {
+        return Write(std::span<const T>{ &value, 1 });
+    }
+
+    // 只写元素，不写长度
+    template<BinarySerializable T>
+    BinaryWriter &Write(std::span<const T> values)
+    {
+        if (!state_.good() || values.empty())
+            return *this;
+
+        if constexpr (BinaryScalar<T>)
+        {
+            if (Detail::NeedByteSwap<T>(endian_))
+            {
+                WriteSwapped_(values);
+                return *this;
+            }
+        }
+        WriteBytes_(values.data(), values.size_bytes());
+        return *this;
+    }
+
+    // 先写uint64长度，再写元素
+    template<BinarySerializable T>
+    BinaryWriter &WriteVector(std::span<const T> values)
+    {
+        Write(static_cast<std::uint64_t>(values.size()));
+        return Write(values);
+    }
+
+    template<BinarySerializable T>
+    BinaryWriter &operator<<(const T &value)
+    {
+        return Write(value);
+    }
+    // 元素可以是const或非const，长度可以是动态或固定的
+    template<BinarySerializable T, std::size_t N>
+    BinaryWriter &operator<<(std::span<T, N> values)
+    {
+        return Write(std::span<const T>{ values });
+    }
+    template<BinarySerializable T>
+    BinaryWriter &operator<<(const std::vector<T> &values)
+    {
+        return WriteVector(std::span<const T>{ values });
+    }
+
+    bool Flush()
+    {
+        if (buf_.pubsync() == -1)
+            state_.setstate(std::ios::badbit);
+        return state_.good();
+    }
+
+    explicit operator bool() const { return state_.good(); }
+
+private:
+    void WriteBytes_(const void *data, std::size_t size)
+    {
+        auto ptr = static_cast<const char *>(data);
+        auto count = static_cast<std::streamsize>(size);
+        if (buf_.sputn(ptr, count) != count)
+            state_.setstate(std::ios::badbit);
+    }
+
+    template<BinaryScalar T>
+    void WriteSwapped_(std::span<const T> values)
+    {
+        while (!values.empty())
+        {
+            auto area = buf_.PrepareWrite(values.size_bytes());
+            auto num = std::min(values.size(), area.size() / sizeof(T));
+            if (num == 0)
+            {
+                // 无缓冲或缓冲区放不下一个元素，退化为逐个写
+                auto swapped = Detail::ByteSwap(values.front());
+                WriteBytes_(&swapped, sizeof(swapped));
+                if (!state_.good())
+                    return;
+                values = values.subspan(1);
+                continue;
+            }
+
+            for (std::size_t i = 0; i < num; i++)
+            {
+                auto swapped = Detail::ByteSwap(values[i]);
+                std::memcpy(area.data() + i * sizeof(T), &swapped, sizeof(T));
+            }
+            buf_.CommitWrite(static_cast<std::streamsize>(num * sizeof(T)));
+            values = values.subspan(num);
+        }
+    }
+
+    TCPBuf &buf_;
+    std::ios &state_;
+    std::endian endian_;
+};
+
+// BinaryWriter的对应读端。出错（含数据不足）时给关联的流设置failbit。
+class BinaryReader
+{
+public:
+    template<typename Stream>
+    explicit BinaryReader(Stream &stream,
+                          std::endian endian = std::endian::little)
+        : buf_{ *stream.rdbuf() }, state_{ stream }, endian_{ endian }
+    {
+    }
+
+    template<BinarySerializable T>
+    BinaryReader &Read(T &value)
+    {
+        return Read(std::span<T>{ &value, 1 });
+    }
+
+    template<BinarySerializable T>
+    BinaryReader &Read(std::span<T> values)
+    {
+        if (!state_.good() || values.empty())
+            return *this;
+
+        ReadBytes_(values.data(), values.size_bytes());
+        if constexpr (BinaryScalar<T>)
+        {
+            if (Detail::NeedByteSwap<T>(endian_) && state_.good())
+            {
+                for (auto &value : values)
+                    value = Detail::ByteSwap(value);
+            }
+        }
+        return *this;
+    }
+
+    // 读取WriteVector写出的数据。长度来自对端，超过maxSize个元素时设置failbit，
+    // 不会按损坏或恶意的长度去分配内存；读取失败时values被清空。
+    template<BinarySerializable T>
+    BinaryReader &ReadVector(std::vector<T> &values,
+                             std::size_t maxSize = std::size_t{ 1 } << 20)
+    {
+        std::uint64_t size = 0;
+        if (Read(size) && (size > maxSize || size > values.max_size()))
+            state_.setstate(std::ios::failbit);
+        if (state_.good())
+        {
+            values.resize(static_cast<std::size_t>(size));
+            Read(std::span<T>{ values });
+        }
+        if (!state_.good())
+            values.clear();
+        return *this;
+    }
+
+    // 尝试直接返回TCPBuf缓冲区中的元素视图，免去拷贝。要求字节序与本机一致、
+    // 数据能在缓冲区中连续放下且地址满足T的对齐；不满足时返回空span且不消费
+    // 任何数据，调用者应改用Read。视图在下一次读取该流之前有效。
+    template<BinarySerializable T>
+    std::span<const T> ReadView(std::size_t count)
+    {
+        if (!state_.good() || Detail::NeedByteSwap<T>(endian_))
+            return {};
+
+        auto size = static_cast<std::streamsize>(count * sizeof(T));
+        auto area = buf_.PeekRead(size);
+        if (area.size() < count * sizeof(T) ||
+            reinterpret_cast<std::uintptr_t>(area.data()) % alignof(T) != 0)
+            return {};
+
+        buf_.ConsumeRead(size);
+        // 缓冲区里的字节就是T的对象表示，T是平凡可复制的。
+        return { reinterpret_cast<const T *>(area.data()), count };
+    }
+
+    template<BinarySerializable T>
+    BinaryReader &operator>>(T &value)
+    {
+        return Read(value);
+    }
+    template<BinarySerializable T, std::size_t N>
+        requires(!std::is_const_v<T>)
+    BinaryReader &operator>>(std::span<T, N> values)
+    {
+        return Read(std::span<T>{ values });
+    }
+    template<BinarySerializable T>
+    BinaryReader &operator>>(std::vector<T> &values)
+    {
+        return ReadVector(values);
+    }
+
+    explicit operator bool() const { return state_.good(); }
+
+private:
+    void ReadBytes_(void *data, std::size_t size)
+    {
+        auto ptr = static_cast<char *>(data);
+        auto count = static_cast<std::streamsize>(size);
+        if (buf_.sgetn(ptr, count) != count)
+            state_.setstate(std::ios::failbit | std::ios::eofbit);
+    }
+
+    TCPBuf &buf_;
+    std::ios &state_;
+    std::endian endian_;
+};
+
+} // namespace Network
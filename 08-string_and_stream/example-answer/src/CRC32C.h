@@ -0,0 +1,247 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define NETWORK_CRC32C_X64 1
+#include <nmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace Network
+{
+
+// CRC-32C (Castagnoli)，iSCSI/ext4/SCTP等使用的那个CRC。
+// x86-64上运行时检测SSE4.2，用crc32指令三路并行计算，再用"追加n个0字节"的
+// 查表算子把三段结果合并（与PCLMUL折叠等价，但不依赖额外的指令集）；
+// 其他平台使用slicing-by-8查表。
+// 与常见实现一致：初始值为0，CRC32C::Update可以分段连续调用。
+class CRC32C
+{
+    static inline constexpr std::uint32_t s_poly_ = 0x82f63b78; // 反射多项式
+    // 并行的每一路长度，必须是2的幂（算子表的构造要求）。
+    static inline constexpr std::size_t s_longBlock_ = 8192;
+    static inline constexpr std::size_t s_shortBlock_ = 256;
+
+    using ByteTable = std::array<std::array<std::uint32_t, 256>, 8>;
+    using ShiftTable = std::array<std::array<std::uint32_t, 256>, 4>;
+
+    struct Tables
+    {
+        ByteTable slicing;
+        ShiftTable longShift;
+        ShiftTable shortShift;
+
+        Tables()
+        {
+            for (std::uint32_t n = 0; n < 256; n++)
+            {
+                auto crc = n;
+                for (int k = 0; k < 8; k++)
+                    crc = crc & 1 ? (crc >> 1) ^ s_poly_ : crc >> 1;
+                slicing[0][n] = crc;
+            }
+            for (std::uint32_t n = 0; n < 256; n++)
+            {
+                auto crc = slicing[0][n];
+                for (std::size_t k = 1; k < 8; k++)
+                {
+                    crc = slicing[0][crc & 0xff] ^ (crc >> 8);
+                    slicing[k][n] = crc;
+                }
+            }
+            BuildShiftTable_(longShift, s_longBlock_);
+            BuildShiftTable_(shortShift, s_shortBlock_);
+        }
+    };
+
+    static const Tables &GetTables_()
+    {
+        static const Tables s_tables;
+        return s_tables;
+    }
+
+public:
+    static std::uint32_t Update(std::uint32_t crc, const void *data,
+                                std::size_t size) noexcept
+    {
+#ifdef NETWORK_CRC32C_X64
+        static const bool s_hasSSE42 = DetectSSE42_();
+        if (s_hasSSE42)
+            return UpdateHardware_(crc, static_cast<const unsigned char *>(data),
+                                   size);
+#endif
+        return UpdateSoftware(crc, data, size);
+    }
+
+    // 可移植实现，也用于测试硬件路径
+    static std::uint32_t UpdateSoftware(std::uint32_t crc, const void *data,
+                                        std::size_t size) noexcept
+    {
+        auto &table = GetTables_().slicing;
+        auto ptr = static_cast<const unsigned char *>(data);
+        crc = ~crc;
+        if constexpr (std::endian::native == std::endian::little)
+        {
+            for (; size >= 8; size -= 8, ptr += 8)
+            {
+                std::uint64_t word;
+                std::memcpy(&word, ptr, sizeof(word));
+                word ^= crc;
+                crc = table[7][word & 0xff] ^ table[6][(word >> 8) & 0xff] ^
+                      table[5][(word >> 16) & 0xff] ^
+                      table[4][(word >> 24) & 0xff] ^
+                      table[3][(word >> 32) & 0xff] ^
+                      table[2][(word >> 40) & 0xff] ^
+                      table[1][(word >> 48) & 0xff] ^ table[0][word >> 56];
+            }
+        }
+        for (; size != 0; size--, ptr++)
+            crc = table[0][(crc ^ *ptr) & 0xff] ^ (crc >> 8);
+        return ~crc;
+    }
+
+private:
+    // GF(2)上32x32矩阵乘向量
+    static std::uint32_t MatrixTimes_(const std::uint32_t *mat,
+                                      std::uint32_t vec) noexcept
+    {
+        std::uint32_t sum = 0;
+        for (; vec != 0; vec >>= 1, mat++)
+        {
+            if (vec & 1)
+                sum ^= *mat;
+        }
+        return sum;
+    }
+
+    static void MatrixSquare_(std::uint32_t *square, const std::uint32_t *mat)
+    {
+        for (int n = 0; n < 32; n++)
+            square[n] = MatrixTimes_(mat, mat[n]);
+    }
+
+    // 构造"在CRC寄存器后追加len个0字节"的算子，并展开成4张按字节查的表。
+    static void BuildShiftTable_(ShiftTable &table, std::size_t len)
+    {
+        std::uint32_t even[32], odd[32];
+        odd[0] = s_poly_; // 1个0比特的算子
+        for (int n = 1; n < 32; n++)
+            odd[n] = 1u << (n - 1);
+        MatrixSquare_(even, odd); // 2个0比特
+        MatrixSquare_(odd, even); // 4个0比特
+
+        // 每平方一次长度翻倍：第一次得到1个0字节的算子
+        const std::uint32_t *op = nullptr;
+        while (true)
+        {
+            MatrixSquare_(even, odd);
+            len >>= 1;
+            if (len == 0)
+            {
+                op = even;
+                break;
+            }
+            MatrixSquare_(odd, even);
+            len >>= 1;
+            if (len == 0)
+            {
+                op = odd;
+                break;
+            }
+        }
+
+        for (std::uint32_t n = 0; n < 256; n++)
+        {
+            table[0][n] = MatrixTimes_(op, n);
+            table[1][n] = MatrixTimes_(op, n << 8);
+            table[2][n] = MatrixTimes_(op, n << 16);
+            table[3][n] = MatrixTimes_(op, n << 24);
+        }
+    }
+
+    static std::uint32_t Shift_(const ShiftTable &table,
+                                std::uint32_t crc) noexcept
+    {
+        return table[0][crc & 0xff] ^ table[1][(crc >> 8) & 0xff] ^
+               table[2][(crc >> 16) & 0xff] ^ table[3][crc >> 24];
+    }
+
+#ifdef NETWORK_CRC32C_X64
+    static bool DetectSSE42_() noexcept
+    {
+#ifdef _MSC_VER
+        int info[4];
+        ::__cpuid(info, 1);
+        return (info[2] & (1 << 20)) != 0;
+#else
+        return __builtin_cpu_supports("sse4.2");
+#endif
+    }
+
+    static std::uint64_t Load64_(const unsigned char *ptr) noexcept
+    {
+        std::uint64_t word;
+        std::memcpy(&word, ptr, sizeof(word));
+        return word;
+    }
+
+    // 三路各处理block字节，结果按顺序合并进crc0
+    template<std::size_t block>
+#ifndef _MSC_VER
+    __attribute__((target("sse4.2")))
+#endif
+    static std::uint64_t
+    UpdateBlocks_(std::uint64_t crc0, const unsigned char *&ptr,
+                  std::size_t &size, const ShiftTable &shift) noexcept
+    {
+        while (size >= block * 3)
+        {
+            std::uint64_t crc1 = 0, crc2 = 0;
+            auto end = ptr + block;
+            do
+            {
+                crc0 = _mm_crc32_u64(crc0, Load64_(ptr));
+                crc1 = _mm_crc32_u64(crc1, Load64_(ptr + block));
+                crc2 = _mm_crc32_u64(crc2, Load64_(ptr + 2 * block));
+                ptr += 8;
+            } while (ptr < end);
+            crc0 = Shift_(shift, static_cast<std::uint32_t>(crc0)) ^ crc1;
+            crc0 = Shift_(shift, static_cast<std::uint32_t>(crc0)) ^ crc2;
+            ptr += 2 * block, size -= 3 * block;
+        }
+        return crc0;
+    }
+
+#ifndef _MSC_VER
+    __attribute__((target("sse4.2")))
+#endif
+    static std::uint32_t
+    UpdateHardware_(std::uint32_t crc, const unsigned char *ptr,
+                    std::size_t size) noexcept
+    {
+        std::uint64_t crc0 = ~crc;
+        for (; size != 0 && reinterpret_cast<std::uintptr_t>(ptr) % 8 != 0;
+             size--, ptr++)
+            crc0 = _mm_crc32_u8(static_cast<std::uint32_t>(crc0), *ptr);
+
+        auto &tables = GetTables_();
+        crc0 = UpdateBlocks_<s_longBlock_>(crc0, ptr, size, tables.longShift);
+        crc0 = UpdateBlocks_<s_shortBlock_>(crc0, ptr, size, tables.shortShift);
+
+        for (; size >= 8; size -= 8, ptr += 8)
+            crc0 = _mm_crc32_u64(crc0, Load64_(ptr));
+        for (; size != 0; size--, ptr++)
+            crc0 = _mm_crc32_u8(static_cast<std::uint32_t>(crc0), *ptr);
+        return ~static_cast<std::uint32_t>(crc0);
+    }
+#endif
+};
+
+} // namespace Network
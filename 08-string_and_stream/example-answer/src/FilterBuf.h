@@ -0,0 +1,162 @@
+#pragma once
+
+#include "CRC32C.h"
+#include <array>
+#include <cstdint>
+#include <streambuf>
+#include <utility>
+
+namespace Network
+{
+
+// 过滤层：自身没有缓冲区，所有读写原样转发给下游streambuf（通常是TCPBuf，也
+// 可以是另一个FilterBuf，从而串成一条链），派生类通过OnWrite_/OnRead_观察
+// 流过的字节。数据只在下游缓冲区里拷贝一次，观察时它们还在缓存里。
+//
+//     TCPBuf &tcp = *stream.rdbuf();
+//     CRC32CFilterBuf crc{ &tcp };
+//     std::ostream out{ &crc };
+//     out << message;
+//     crc.EndFrame(); // 追加4字节校验和
+class FilterBuf : public std::basic_streambuf<char>
+{
+    using Base = std::basic_streambuf<char>;
+    static inline constexpr int_type s_EOF_ = traits_type::eof();
+
+public:
+    explicit FilterBuf(Base *next = nullptr) noexcept : next_{ next } {}
+    FilterBuf(const FilterBuf &) = delete;
+    FilterBuf &operator=(const FilterBuf &) = delete;
+
+    Base *GetNext() const noexcept { return next_; }
+    void SetNext(Base *next) noexcept { next_ = next; }
+
+protected:
+    virtual void OnWrite_(const char_type *, std::streamsize) {}
+    virtual void OnRead_(const char_type *, std::streamsize) {}
+
+    // --------------- Output related -----------------
+    int_type overflow(int_type ch = s_EOF_) override
+    {
+        if (next_ == nullptr)
+            return s_EOF_;
+        if (traits_type::eq_int_type(ch, s_EOF_))
+            return traits_type::not_eof(ch);
+
+        char_type realCh = traits_type::to_char_type(ch);
+        if (traits_type::eq_int_type(next_->sputc(realCh), s_EOF_))
+            return s_EOF_;
+        OnWrite_(&realCh, 1);
+        return ch;
+    }
+
+    std::streamsize xsputn(const char_type *s, std::streamsize count) override
+    {
+        if (next_ == nullptr)
+            return 0;
+        auto successSize = next_->sputn(s, count);
+        // 只统计真正交给下游的部分
+        OnWrite_(s, successSize);
+        return successSize;
+    }
+
+    int sync() override { return next_ == nullptr ? -1 : next_->pubsync(); }
+
+    // --------------- Input related -----------------
+    // 没有get区，underflow只是偷看下游的下一个字节，真正消费在uflow里。
+    int_type underflow() override
+    {
+        return next_ == nullptr ? s_EOF_ : next_->sgetc();
+    }
+
+    int_type uflow() override
+    {
+        if (next_ == nullptr)
+            return s_EOF_;
+        auto ch = next_->sbumpc();
+        if (!traits_type::eq_int_type(ch, s_EOF_))
+        {
+            char_type realCh = traits_type::to_char_type(ch);
+            OnRead_(&realCh, 1);
+        }
+        return ch;
+    }
+
+    std::streamsize xsgetn(char_type *s, std::streamsize count) override
+    {
+        if (next_ == nullptr)
+            return 0;
+        auto successSize = next_->sgetn(s, count);
+        OnRead_(s, successSize);
+        return successSize;
+    }
+
+    std::streamsize showmanyc() override
+    {
+        return next_ == nullptr ? -1 : next_->in_avail();
+    }
+
+    // 绕过OnWrite_/OnRead_直接读写下游，用于帧尾等不参与过滤的数据
+    bool WriteThrough_(const char_type *s, std::streamsize count)
+    {
+        return next_ != nullptr && next_->sputn(s, count) == count;
+    }
+    bool ReadThrough_(char_type *s, std::streamsize count)
+    {
+        return next_ != nullptr && next_->sgetn(s, count) == count;
+    }
+
+private:
+    Base *next_;
+};
+
+// 对一帧内写出（或读入）的字节计算CRC32C。写端EndFrame在帧尾追加4字节小端
+// 校验和；读端读完一帧后调用CheckFrame读取并核对校验和。帧的边界由上层协议
+// 决定（例如长度前缀），两端调用的位置必须对应。
+class CRC32CFilterBuf : public FilterBuf
+{
+public:
+    using FilterBuf::FilterBuf;
+
+    bool EndFrame()
+    {
+        auto trailer = Encode_(std::exchange(writeCRC_, 0));
+        return WriteThrough_(trailer.data(), trailer.size());
+    }
+
+    bool CheckFrame()
+    {
+        std::array<char_type, 4> trailer;
+        if (!ReadThrough_(trailer.data(), trailer.size()))
+            return false;
+        return Encode_(std::exchange(readCRC_, 0)) == trailer;
+    }
+
+    std::uint32_t GetWriteCRC() const noexcept { return writeCRC_; }
+    std::uint32_t GetReadCRC() const noexcept { return readCRC_; }
+
+protected:
+    void OnWrite_(const char_type *s, std::streamsize size) override
+    {
+        writeCRC_ = CRC32C::Update(writeCRC_, s, static_cast<std::size_t>(size));
+    }
+
+    void OnRead_(const char_type *s, std::streamsize size) override
+    {
+        readCRC_ = CRC32C::Update(readCRC_, s, static_cast<std::size_t>(size));
+    }
+
+private:
+    static std::array<char_type, 4> Encode_(std::uint32_t crc) noexcept
+    {
+        return { static_cast<char_type>(crc & 0xff),
+                 static_cast<char_type>((crc >> 8) & 0xff),
+                 static_cast<char_type>((crc >> 16) & 0xff),
+                 static_cast<char_type>(crc >> 24) };
+    }
+
+    std::uint32_t writeCRC_ = 0;
+    std::uint32_t readCRC_ = 0;
+};
+
+} // namespace Network
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace KV
+{
+
+// 按key的hash分片，每个分片一把读写锁，不同分片的操作互不干扰。
+class ShardedStore
+{
+    static inline constexpr std::size_t s_cacheLineSize_ = 64;
+
+    struct StringHash
+    {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view str) const noexcept
+        {
+            return std::hash<std::string_view>{}(str);
+        }
+    };
+
+    // 对齐到缓存行，避免相邻分片的锁互相伪共享
+    struct alignas(s_cacheLineSize_) Shard
+    {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, std::string, StringHash,
+                           std::equal_to<>>
+            map;
+    };
+
+public:
+    // 至少一个分片，否则GetShard_里取模会除以0
+    explicit ShardedStore(std::size_t shardNum = 64)
+        : shards_{ std::make_unique<Shard[]>(std::max<std::size_t>(shardNum, 1)) },
+          shardNum_{ std::max<std::size_t>(shardNum, 1) }
+    {
+    }
+
+    std::optional<std::string> Get(std::string_view key) const
+    {
+        auto &shard = GetShard_(key);
+        std::shared_lock lock{ shard.mutex };
+        auto it = shard.map.find(key);
+        if (it == shard.map.end())
+            return std::nullopt;
+        return it->second;
+    }
+
+    void Set(std::string_view key, std::string_view value)
+    {
+        auto &shard = GetShard_(key);
+        std::lock_guard lock{ shard.mutex };
+        auto it = shard.map.find(key);
+        if (it == shard.map.end())
+            shard.map.emplace(key, value);
+        else
+            it->second.assign(value);
+    }
+
+    // 返回是否真的删除了
+    bool Del(std::string_view key)
+    {
+        auto &shard = GetShard_(key);
+        std::lock_guard lock{ shard.mutex };
+        auto it = shard.map.find(key);
+        if (it == shard.map.end())
+            return false;
+        shard.map.erase(it);
+        return true;
+    }
+
+    auto GetShardNum() const noexcept { return shardNum_; }
+
+private:
+    Shard &GetShard_(std::string_view key) const noexcept
+    {
+        return shards_[StringHash{}(key) % shardNum_];
+    }
+
+    std::unique_ptr<Shard[]> shards_;
+    std::size_t shardNum_;
+};
+
+} // namespace KV
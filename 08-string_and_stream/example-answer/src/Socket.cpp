@@ -1,5 +1,7 @@
 #include "Socket.h"
+#include <cstring>
 #include <stdexcept>
+#include <vector>
 
 #ifdef _WIN32
 
@@ -9,6 +11,10 @@
 #else
 
 #include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/tcp.h>
+#include <poll.h>
 #include <unistd.h>
 
 #endif
@@ -39,36 +45,65 @@ Socket::Socket(const Socket &listenSock, Tag tag)
         throw std::runtime_error{ "Unknown tag.\n" };
     }
 
-    sockaddr_in addr;
+    sockaddr_storage addr;
     socklen_t addrLen = sizeof(addr);
     socket_ = ::accept(listenSock.socket_, reinterpret_cast<sockaddr *>(&addr),
                        &addrLen);
 }
 
-bool Socket::CreateSocketCommon_(const char *ip, std::uint16_t port,
-                                 sockaddr_in &addr)
+std::size_t Socket::ParseAddress_(const char *ip, std::uint16_t port,
+                                  sockaddr_storage &addr)
 {
     addr = {};
-    addr.sin_family = AF_INET;
-    if (::inet_pton(AF_INET, ip, &addr.sin_addr) == 0) // Wrong IP format.
+    auto &addr4 = reinterpret_cast<sockaddr_in &>(addr);
+    if (::inet_pton(AF_INET, ip, &addr4.sin_addr) == 1)
     {
-        return false;
+        addr4.sin_family = AF_INET;
+        addr4.sin_port = ::htons(port);
+        return sizeof(sockaddr_in);
+    }
+
+    auto &addr6 = reinterpret_cast<sockaddr_in6 &>(addr);
+    if (::inet_pton(AF_INET6, ip, &addr6.sin6_addr) == 1)
+    {
+        addr6.sin6_family = AF_INET6;
+        addr6.sin6_port = ::htons(port);
+        return sizeof(sockaddr_in6);
+    }
+    return 0; // Wrong IP format.
+}
+
+std::size_t Socket::CreateSocketCommon_(const char *ip, std::uint16_t port,
+                                        sockaddr_storage &addr)
+{
+    auto addrLen = ParseAddress_(ip, port, addr);
+    if (addrLen == 0)
+    {
+        return 0;
     }
-    addr.sin_port = ::htons(port);
-    socket_ = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-    return socket_ != s_invalidSocket_;
+    socket_ = ::socket(addr.ss_family, SOCK_STREAM, IPPROTO_TCP);
+    return socket_ != s_invalidSocket_ ? addrLen : 0;
 }
 
 void Socket::CreateListenSocket_(const char *ip, std::uint16_t port)
 {
-    sockaddr_in addr;
-    if (!CreateSocketCommon_(ip, port, addr))
+    sockaddr_storage addr;
+    auto addrLen = CreateSocketCommon_(ip, port, addr);
+    if (addrLen == 0)
     {
         return;
     }
 
-    if (::bind(socket_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) ==
-        -1)
+    if (addr.ss_family == AF_INET6)
+    {
+        // Dual-stack: also accept IPv4 peers as IPv4-mapped addresses.
+        int v6Only = 0;
+        ::setsockopt(socket_, IPPROTO_IPV6, IPV6_V6ONLY,
+                     reinterpret_cast<const char *>(&v6Only), sizeof(v6Only));
+    }
+
+    if (::bind(socket_, reinterpret_cast<sockaddr *>(&addr),
+               static_cast<socklen_t>(addrLen)) == -1)
     {
         Close();
     }
@@ -81,19 +116,187 @@ void Socket::CreateListenSocket_(const char *ip, std::uint16_t port)
 
 void Socket::CreateConnectSocket_(const char *ip, std::uint16_t port)
 {
-    sockaddr_in addr;
-    if (!CreateSocketCommon_(ip, port, addr))
+    sockaddr_storage addr;
+    auto addrLen = CreateSocketCommon_(ip, port, addr);
+    if (addrLen == 0)
     {
         return;
     }
 
-    if (::connect(socket_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) ==
-        -1)
+    if (::connect(socket_, reinterpret_cast<sockaddr *>(&addr),
+                  static_cast<socklen_t>(addrLen)) == -1)
     {
         Close();
     }
 }
 
+bool Socket::SetNonBlocking_(Handle handle, bool enable)
+{
+#ifdef _WIN32
+    u_long mode = enable ? 1 : 0;
+    return ::ioctlsocket(handle, FIONBIO, &mode) == 0;
+#else
+    int flags = ::fcntl(handle, F_GETFL, 0);
+    if (flags == -1)
+    {
+        return false;
+    }
+    flags = enable ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+    return ::fcntl(handle, F_SETFL, flags) == 0;
+#endif
+}
+
+Socket Socket::ConnectFirst(std::span<const char *const> ips,
+                            std::uint16_t port,
+                            std::chrono::milliseconds timeout)
+{
+    std::vector<sockaddr_storage> addrs;
+    addrs.reserve(ips.size());
+    for (auto ip : ips)
+    {
+        sockaddr_storage addr;
+        if (ParseAddress_(ip, port, addr) != 0)
+        {
+            addrs.push_back(addr);
+        }
+    }
+    return RaceConnect_(addrs, timeout);
+}
+
+Socket Socket::ConnectHost(const char *host, std::uint16_t port,
+                           std::chrono::milliseconds timeout)
+{
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+
+    addrinfo *result = nullptr;
+    if (::getaddrinfo(host, nullptr, &hints, &result) != 0)
+    {
+        return Socket{};
+    }
+
+    std::vector<sockaddr_storage> addrs;
+    for (auto info = result; info != nullptr; info = info->ai_next)
+    {
+        if (info->ai_family != AF_INET && info->ai_family != AF_INET6)
+        {
+            continue;
+        }
+        sockaddr_storage addr{};
+        std::memcpy(&addr, info->ai_addr, info->ai_addrlen);
+        auto portNet = ::htons(port);
+        if (info->ai_family == AF_INET)
+            reinterpret_cast<sockaddr_in &>(addr).sin_port = portNet;
+        else
+            reinterpret_cast<sockaddr_in6 &>(addr).sin6_port = portNet;
+        addrs.push_back(addr);
+    }
+    ::freeaddrinfo(result);
+    return RaceConnect_(addrs, timeout);
+}
+
+Socket Socket::RaceConnect_(std::span<const sockaddr_storage> addrs,
+                            std::chrono::milliseconds timeout)
+{
+    using Clock = std::chrono::steady_clock;
+    auto deadline = Clock::now() + timeout;
+
+    // pending[i] is the socket of fds[i]; both shrink as attempts fail.
+    std::vector<Socket> pending;
+    std::vector<pollfd> fds;
+    for (auto &addr : addrs)
+    {
+        Socket sock{ ::socket(addr.ss_family, SOCK_STREAM, IPPROTO_TCP) };
+        if (!sock || !SetNonBlocking_(sock.socket_, true))
+        {
+            continue;
+        }
+
+        socklen_t addrLen = addr.ss_family == AF_INET ? sizeof(sockaddr_in)
+                                                      : sizeof(sockaddr_in6);
+        if (::connect(sock.socket_, reinterpret_cast<const sockaddr *>(&addr),
+                      addrLen) == 0)
+        {
+            // Connected immediately (typical for loopback); no need to race.
+            SetNonBlocking_(sock.socket_, false);
+            return sock;
+        }
+
+        auto error = GetErrorCode();
+#ifdef _WIN32
+        bool inProgress = error == WSAEWOULDBLOCK;
+#else
+        bool inProgress = error == EINPROGRESS;
+#endif
+        if (inProgress)
+        {
+            fds.push_back(pollfd{ sock.socket_, POLLOUT, 0 });
+            pending.push_back(std::move(sock));
+        }
+    }
+
+    while (!fds.empty())
+    {
+        auto remain = std::chrono::ceil<std::chrono::milliseconds>(
+            deadline - Clock::now());
+        if (remain.count() <= 0)
+        {
+            break;
+        }
+
+#ifdef _WIN32
+        int ready = ::WSAPoll(fds.data(), static_cast<ULONG>(fds.size()),
+                              static_cast<int>(remain.count()));
+#else
+        int ready = ::poll(fds.data(), fds.size(),
+                           static_cast<int>(remain.count()));
+#endif
+#ifdef _WIN32
+        if (ready < 0 && GetErrorCode() != WSAEINTR)
+#else
+        if (ready < 0 && GetErrorCode() != EINTR)
+#endif
+        {
+            break;
+        }
+
+        for (std::size_t i = 0; i < fds.size();)
+        {
+            if (fds[i].revents == 0)
+            {
+                i++;
+                continue;
+            }
+
+            int error = 0;
+            socklen_t errorLen = sizeof(error);
+            ::getsockopt(fds[i].fd, SOL_SOCKET, SO_ERROR,
+                         reinterpret_cast<char *>(&error), &errorLen);
+            if (error == 0)
+            {
+                // The losers are closed by their destructors.
+                auto winner = std::move(pending[i]);
+                SetNonBlocking_(winner.socket_, false);
+                return winner;
+            }
+
+            fds.erase(fds.begin() + i);
+            pending.erase(pending.begin() + i);
+        }
+    }
+    return Socket{};
+}
+
+bool Socket::SetNoDelay(bool enable) noexcept
+{
+    int flag = enable ? 1 : 0;
+    return ::setsockopt(socket_, IPPROTO_TCP, TCP_NODELAY,
+                        reinterpret_cast<const char *>(&flag),
+                        sizeof(flag)) == 0;
+}
+
 void Socket::Clean_()
 {
 #ifdef _WIN32
@@ -15,7 +15,10 @@
 #endif
 
 #include <cerrno>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <span>
 #include <stdexcept>
 #include <utility>
 
@@ -25,12 +28,13 @@ namespace Network
 class Socket
 {
 #ifdef _WIN32
-    inline static constexpr SOCKET s_invalidSocket_ = INVALID_SOCKET;
-    SOCKET socket_{ s_invalidSocket_ };
+    using Handle = SOCKET;
+    inline static constexpr Handle s_invalidSocket_ = INVALID_SOCKET;
 #else
-    inline static constexpr int s_invalidSocket_ = -1;
-    int socket_{ s_invalidSocket_ };
+    using Handle = int;
+    inline static constexpr Handle s_invalidSocket_ = -1;
 #endif
+    Handle socket_{ s_invalidSocket_ };
 
 public:
     enum class Tag
@@ -42,7 +46,8 @@ public:
 
     Socket() = default;
 
-    // Listen socket or connect socket.
+    // Listen socket or connect socket. ip can be either IPv4 or IPv6; an IPv6
+    // listen socket (e.g. "::") is dual-stack and accepts IPv4 peers as well.
     Socket(const char *ip, std::uint16_t port, Tag tag);
 
     // Accept socket; To distinguish it from copy ctor (in fact socket doesn't
@@ -86,9 +91,34 @@ public:
     }
     auto GetHandle() const noexcept { return socket_; }
 
+    // Start non-blocking connects to all candidates at once, keep the first
+    // one that completes and close the rest. Returns an invalid socket if all
+    // of them fail or the timeout expires.
+    static Socket ConnectFirst(std::span<const char *const> ips,
+                               std::uint16_t port,
+                               std::chrono::milliseconds timeout);
+
+    // Resolve host into all of its IPv4 and IPv6 addresses, then race them like
+    // ConnectFirst.
+    static Socket ConnectHost(const char *host, std::uint16_t port,
+                              std::chrono::milliseconds timeout);
+
+    // Disable Nagle's algorithm, so small request/response packets are not
+    // delayed for coalescing.
+    bool SetNoDelay(bool enable = true) noexcept;
+
 private:
-    bool CreateSocketCommon_(const char *ip, std::uint16_t port,
-                             sockaddr_in &addr);
+    explicit Socket(Handle handle) noexcept : socket_{ handle } {}
+
+    // Returns the length of addr, or 0 if ip is neither IPv4 nor IPv6.
+    static std::size_t ParseAddress_(const char *ip, std::uint16_t port,
+                                     sockaddr_storage &addr);
+    static bool SetNonBlocking_(Handle handle, bool enable);
+    static Socket RaceConnect_(std::span<const sockaddr_storage> addrs,
+                               std::chrono::milliseconds timeout);
+
+    std::size_t CreateSocketCommon_(const char *ip, std::uint16_t port,
+                                    sockaddr_storage &addr);
     void CreateListenSocket_(const char *ip, std::uint16_t port);
     void CreateConnectSocket_(const char *ip, std::uint16_t port);
     void Clean_();
@@ -3,13 +3,17 @@
 #include "Socket.h"
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstring>
 #include <ios>
 #include <iostream>
 #include <limits>
+#include <span>
 #include <streambuf>
+#include <system_error>
 
 #ifndef _WIN32
+#include <poll.h>
 #include <sys/ioctl.h>
 #endif
 
@@ -98,10 +102,14 @@ class TCPBuf : public std::basic_streambuf<char>
     static inline constexpr int_type s_NotEOF_ = traits_type::not_eof(0);
 
 public:
+    using Clock = std::chrono::steady_clock;
+    static inline constexpr Clock::time_point s_noDeadline_ =
+        Clock::time_point::max();
+
     TCPBuf() = default;
     TCPBuf(const TCPBuf &) = delete;
     TCPBuf(TCPBuf &&another) = default;
-    ~TCPBuf() override { FlushBuffer_(); }
+    ~TCPBuf() override { FlushBuffer_(GetOpDeadline_()); }
 
     TCPBuf *open(Socket &&socket, std::ios::openmode mode,
                  std::streamsize inSize, std::streamsize outSize)
@@ -123,6 +131,7 @@ public:
 
         socket_ = std::move(socket);
         inBuffer_ = std::move(inBuffer), outBuffer_ = std::move(outBuffer);
+        lastError_.clear();
         return this;
     }
 
@@ -130,7 +139,7 @@ public:
 
     TCPBuf *close() noexcept
     {
-        FlushBuffer_();
+        FlushBuffer_(GetOpDeadline_());
         socket_.Close();
         inBuffer_.SetBuffer(nullptr, 0);
         outBuffer_.SetBuffer(nullptr, 0);
@@ -139,20 +148,156 @@ public:
         return this;
     }
 
+    // 每次阻塞操作（一次overflow/xsputn/sync/underflow/xsgetn）最多等待的时间，
+    // 0表示不限时。
+    void SetTimeout(std::chrono::milliseconds timeout) noexcept
+    {
+        timeout_ = timeout;
+    }
+    auto GetTimeout() const noexcept { return timeout_; }
+
+    // 绝对截止时间，对之后的所有操作生效，直到ClearDeadline。
+    // 与timeout同时存在时取较早的那个。
+    void SetDeadline(Clock::time_point deadline) noexcept
+    {
+        deadline_ = deadline;
+    }
+    void ClearDeadline() noexcept { deadline_ = s_noDeadline_; }
+
+    // 超时为std::errc::timed_out，socket出错为对应的系统错误码；
+    // 对端正常关闭只是EOF，不算错误。错误会一直保留，直到ClearError或重新open。
+    std::error_code GetError() const noexcept { return lastError_; }
+    void ClearError() noexcept { lastError_.clear(); }
+
+    // 直接访问put区/get区，供二进制读写等需要避免中间拷贝的场合使用。
+    // 返回put区的剩余空间；不足size时先尝试flush，因此结果仍可能小于size
+    // （缓冲区太小、无缓冲或发送失败），调用者需检查。
+    std::span<char_type> PrepareWrite(std::streamsize size)
+    {
+        if (epptr() - pptr() < size && socket_)
+            FlushBuffer_(GetOpDeadline_());
+        return { pptr(), epptr() };
+    }
+    void CommitWrite(std::streamsize size) noexcept
+    {
+        assert(size <= epptr() - pptr());
+        pbump(static_cast<int>(size));
+    }
+
+    // 返回get区中连续可读的数据；不足size时把剩余数据挪到缓冲区开头并继续
+    // 接收，直到凑够size、缓冲区满或出错。
+    std::span<const char_type> PeekRead(std::streamsize size)
+    {
+        if (egptr() - gptr() < size && socket_ &&
+            inBuffer_.GetRawBuffer() != nullptr)
+            FillBuffer_(size, GetOpDeadline_());
+        return { gptr(), egptr() };
+    }
+    void ConsumeRead(std::streamsize size) noexcept
+    {
+        assert(size <= egptr() - gptr());
+        gbump(static_cast<int>(size));
+    }
+
     // overflow -> 溢出的时候调用
     // sync -> flush调用
     // xsputn -> bulk write
 private:
+#ifdef MSG_DONTWAIT
+    // poll报告可写不代表能一次写完，阻塞的send仍可能卡住，因此有截止时间时
+    // 只写入当前能写的部分，剩余的回到poll继续等。
+    static inline constexpr int s_noWaitFlag_ = MSG_DONTWAIT;
+#else
+    static inline constexpr int s_noWaitFlag_ = 0;
+#endif
+
+    Clock::time_point GetOpDeadline_() const noexcept
+    {
+        if (timeout_.count() <= 0)
+            return deadline_;
+        return std::min(deadline_, Clock::now() + timeout_);
+    }
+
+    // 等待socket可读（或可写）直到deadline；超时或出错时记录错误并返回false。
+    bool WaitUntilReady_(bool forRead, Clock::time_point deadline)
+    {
+        if (deadline == s_noDeadline_)
+            return true;
+
+        while (true)
+        {
+            auto remain = std::chrono::ceil<std::chrono::milliseconds>(
+                deadline - Clock::now());
+            if (remain.count() <= 0)
+            {
+                lastError_ = std::make_error_code(std::errc::timed_out);
+                return false;
+            }
+
+            pollfd fd{};
+            fd.fd = socket_.GetHandle();
+            fd.events = forRead ? POLLIN : POLLOUT;
+            auto timeout = static_cast<int>(std::min<std::int64_t>(
+                remain.count(), std::numeric_limits<int>::max()));
+#ifdef _WIN32
+            int result = ::WSAPoll(&fd, 1, timeout);
+#else
+            int result = ::poll(&fd, 1, timeout);
+#endif
+            if (result > 0)
+                return true;
+            if (result < 0 && !IsInterrupted_())
+            {
+                RecordSocketError_();
+                return false;
+            }
+            // result == 0或被信号打断，重新计算剩余时间
+        }
+    }
+
+    bool IsInterrupted_() const
+    {
+#ifdef _WIN32
+        return GetErrorCode() == WSAEINTR;
+#else
+        return GetErrorCode() == EINTR;
+#endif
+    }
+
+    void RecordSocketError_()
+    {
+        lastError_ = std::error_code{ static_cast<int>(GetErrorCode()),
+                                      std::system_category() };
+    }
+
+    bool IsRetryableError_() const
+    {
+        auto code = GetErrorCode();
+#ifdef _WIN32
+        return code == WSAEWOULDBLOCK || code == WSAEINTR;
+#else
+        return code == EAGAIN || code == EWOULDBLOCK || code == EINTR;
+#endif
+    }
+
     // 返回未写入的大小
-    std::streamsize SendAsMuchAsPossible_(const char *ptr, std::streamsize size)
+    std::streamsize SendAsMuchAsPossible_(const char *ptr, std::streamsize size,
+                                          Clock::time_point deadline)
     {
         assert(size <= std::numeric_limits<int>::max());
+        int flags = deadline == s_noDeadline_ ? 0 : s_noWaitFlag_;
         while (size != 0)
         {
+            if (!WaitUntilReady_(false, deadline))
+                break;
+
             int resultSize =
-                ::send(socket_.GetHandle(), ptr, static_cast<int>(size), 0);
+                ::send(socket_.GetHandle(), ptr, static_cast<int>(size), flags);
             if (resultSize <= 0)
             {
+                if (resultSize < 0 && IsRetryableError_())
+                    continue;
+                RecordSocketError_();
                 break;
             }
             size -= resultSize, ptr += resultSize;
@@ -171,13 +316,14 @@ private:
         return;
     }
 
-    std::streamsize RecvAsMuchAsPossible_(char *ptr, std::streamsize size)
+    // 返回未读入的大小
+    std::streamsize RecvAsMuchAsPossible_(char *ptr, std::streamsize size,
+                                          Clock::time_point deadline)
     {
         assert(size <= std::numeric_limits<int>::max());
         while (size != 0)
         {
-            int resultSize =
-                ::recv(socket_.GetHandle(), ptr, static_cast<int>(size), 0);
+            int resultSize = RecvSome_(ptr, size, deadline);
             if (resultSize <= 0)
             {
                 break;
@@ -187,6 +333,26 @@ private:
         return size;
     }
 
+    // 最多读入size字节，返回值与recv相同；出错（含超时）时记录错误。
+    int RecvSome_(char *ptr, std::streamsize size, Clock::time_point deadline)
+    {
+        while (true)
+        {
+            if (!WaitUntilReady_(true, deadline))
+                return -1;
+
+            int resultSize =
+                ::recv(socket_.GetHandle(), ptr, static_cast<int>(size), 0);
+            if (resultSize < 0)
+            {
+                if (IsRetryableError_())
+                    continue;
+                RecordSocketError_();
+            }
+            return resultSize;
+        }
+    }
+
     auto GetInputRemainSize_() const noexcept { return egptr() - gptr(); }
 
     void MemcpyFromInputBuffer_(char_type *s, std::streamsize size) noexcept
@@ -205,18 +371,17 @@ protected:
         if (traits_type::eq_int_type(ch, s_EOF_))
             return s_NotEOF_;
 
+        auto deadline = GetOpDeadline_();
         if (outBuffer_.GetRawBuffer() == nullptr)
         {
             char_type realCh = ch;
-
-            return ::send(socket_.GetHandle(), &realCh, sizeof(realCh), 0) ==
-                           sizeof(realCh)
+            return SendAsMuchAsPossible_(&realCh, sizeof(realCh), deadline) == 0
                        ? s_NotEOF_
                        : s_EOF_;
         }
 
         // 腾出空间，写字节
-        FlushBuffer_();
+        FlushBuffer_(deadline);
         if (GetOutputRemainSize_() == 0)
         {
             return s_EOF_;
@@ -239,9 +404,10 @@ protected:
         }
 
         std::streamsize successSize = 0;
-        if (FlushBuffer_())
+        auto deadline = GetOpDeadline_();
+        if (FlushBuffer_(deadline))
         {
-            auto failSize = SendAsMuchAsPossible_(s, count);
+            auto failSize = SendAsMuchAsPossible_(s, count, deadline);
             if (failSize == 0)
             {
                 return count;
@@ -256,9 +422,9 @@ protected:
         return successSize + largestSize;
     }
 
-    int sync() override { return FlushBuffer_() ? 0 : -1; }
+    int sync() override { return FlushBuffer_(GetOpDeadline_()) ? 0 : -1; }
 
-    bool FlushBuffer_()
+    bool FlushBuffer_(Clock::time_point deadline)
     {
         // [pbase, pptr) 已经有内容，进行刷新（全部写出）
         auto begPtr = this->pbase();
@@ -269,7 +435,7 @@ protected:
         }
 
         // 不是空就要刷新
-        auto failSize = SendAsMuchAsPossible_(begPtr, msgSize);
+        auto failSize = SendAsMuchAsPossible_(begPtr, msgSize, deadline);
         if (failSize == 0)
         {
             this->setp(outBuffer_.begin(), outBuffer_.end());
@@ -281,6 +447,24 @@ protected:
     }
 
     // --------------- Input related -----------------
+    void FillBuffer_(std::streamsize size, Clock::time_point deadline)
+    {
+        auto remainSize = GetInputRemainSize_();
+        std::memmove(inBuffer_.begin(), gptr(), remainSize);
+        setg(inBuffer_.begin(), inBuffer_.begin(),
+             inBuffer_.begin() + remainSize);
+
+        while (remainSize < size && egptr() != inBuffer_.end())
+        {
+            int resultSize = RecvSome_(egptr(), inBuffer_.end() - egptr(),
+                                       deadline);
+            if (resultSize <= 0)
+                break;
+            remainSize += resultSize;
+            setg(eback(), gptr(), egptr() + resultSize);
+        }
+    }
+
     std::streamsize showmanyc() override
     {
         unsigned long size = 0;
@@ -313,15 +497,16 @@ protected:
         if (!socket_)
             return s_EOF_;
 
+        auto deadline = GetOpDeadline_();
         if (inBuffer_.GetRawBuffer() == nullptr)
         {
             char_type ch;
-            return ::recv(socket_.GetHandle(), &ch, sizeof(ch), 0) != sizeof(ch)
+            return RecvSome_(&ch, sizeof(ch), deadline) != sizeof(ch)
                        ? s_EOF_
                        : ch;
         }
 
-        if (!SyncBuffer_())
+        if (!SyncBuffer_(deadline))
             return s_EOF_;
 
         // getc表示得到当前的字符并不前进，与underflow要求相同。
@@ -341,11 +526,12 @@ protected:
         }
 
         MemcpyFromInputBuffer_(s, copySize);
-        auto failSize = RecvAsMuchAsPossible_(s + copySize, count - copySize);
+        auto failSize = RecvAsMuchAsPossible_(s + copySize, count - copySize,
+                                              GetOpDeadline_());
         return count - failSize;
     }
 
-    bool SyncBuffer_()
+    bool SyncBuffer_(Clock::time_point deadline)
     {
         assert(this->egptr() == this->gptr());
         if (this->gptr() == nullptr)
@@ -353,8 +539,8 @@ protected:
             return true;
         }
 
-        std::streamsize successSize = ::recv(
-            socket_.GetHandle(), inBuffer_.begin(), inBuffer_.GetSize(), 0);
+        std::streamsize successSize =
+            RecvSome_(inBuffer_.begin(), inBuffer_.GetSize(), deadline);
         if (successSize <= 0)
             return false;
 
@@ -367,6 +553,9 @@ private:
     Socket socket_;
     UserManagableBuffer<char_type> inBuffer_;
     UserManagableBuffer<char_type> outBuffer_;
+    std::chrono::milliseconds timeout_{ 0 };
+    Clock::time_point deadline_ = s_noDeadline_;
+    std::error_code lastError_;
 };
 
 } // namespace Network
\ No newline at end of file
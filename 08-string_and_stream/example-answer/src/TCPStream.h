@@ -50,4 +50,29 @@ private:
     TCPBuf buf_;
 };
 
+// 同一个连接既读又写（例如请求-响应协议），两个方向共用一个socket。
+class TCPStream : public std::basic_iostream<char>
+{
+    using Base = std::basic_iostream<char>;
+
+public:
+    TCPStream() : Base{ &buf_ } {}
+
+    void open(Socket &&socket, std::streamsize inSize, std::streamsize outSize)
+    {
+        buf_.open(std::move(socket), std::ios::in | std::ios::out, inSize,
+                  outSize);
+    }
+
+    void close() { buf_.close(); }
+
+    bool is_open() const noexcept { return buf_.is_open(); }
+
+    const TCPBuf *rdbuf() const noexcept { return &buf_; }
+    TCPBuf *rdbuf() noexcept { return &buf_; }
+
+private:
+    TCPBuf buf_;
+};
+
 } // namespace Network
\ No newline at end of file
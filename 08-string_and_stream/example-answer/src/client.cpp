@@ -3,11 +3,13 @@
 #include <print>
 #include <string_view>
 
+using namespace std::chrono_literals;
+
 int main()
 {
     Network::Startup();
-    Network::Socket connectSocket{ "127.0.0.1", 34567,
-                                   Network::Socket::Tag::Connect };
+    // localhost可能同时解析出::1和127.0.0.1，哪个先连上就用哪个。
+    auto connectSocket = Network::Socket::ConnectHost("localhost", 34567, 3s);
     if (!connectSocket)
     {
         std::println("Connect socket error: {}", Network::GetErrorCode());
@@ -0,0 +1,311 @@
+#include "TCPStream.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <print>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// kv_server的压测客户端。每个连接一个线程，每轮连续发送pipeline个请求再统一
+// 读取回复，统计吞吐量和每轮往返延迟。
+// 用法：kv_client [--port=34568] [--connections=4] [--requests=100000]
+//                 [--pipeline=16] [--keys=100000] [--dist=uniform|zipf]
+//                 [--zipf=0.99] [--get-ratio=0.9] [--value-size=16]
+// 一轮请求按最长的请求估算不能超过32KB，pipeline超出时自动减小到能放下的个数
+// （value越大，能放下的越少，最少1个）。
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+// 客户端写完一整轮才开始读回复。一轮太大的话，服务器的回复先把两端的socket
+// 缓冲区塞满，服务器停下来不再读请求，客户端的send也就永远写不完。一轮的请求
+// 和回复都不超过这个大小（远小于常见的默认socket缓冲区），就不会互相等待。
+constexpr std::size_t s_maxBatchBytes = 32 * 1024;
+
+struct Options
+{
+    std::uint16_t port = 34568;
+    int connections = 4;
+    std::int64_t requests = 100000; // 每个连接
+    int pipeline = 16;
+    std::size_t keys = 100000;
+    bool zipf = false;
+    double zipfSkew = 0.99;
+    double getRatio = 0.9;
+    std::size_t valueSize = 16;
+};
+
+template<typename T>
+bool ParseNumber(std::string_view str, T &result)
+{
+    auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), result);
+    return ec == std::errc{} && ptr == str.data() + str.size();
+}
+
+bool ParseOptions(int argc, char **argv, Options &options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string_view arg{ argv[i] };
+        auto pos = arg.find('=');
+        if (!arg.starts_with("--") || pos == std::string_view::npos)
+            return false;
+
+        auto name = arg.substr(2, pos - 2), value = arg.substr(pos + 1);
+        bool ok = true;
+        if (name == "port")
+            ok = ParseNumber(value, options.port);
+        else if (name == "connections")
+            ok = ParseNumber(value, options.connections);
+        else if (name == "requests")
+            ok = ParseNumber(value, options.requests);
+        else if (name == "pipeline")
+            ok = ParseNumber(value, options.pipeline);
+        else if (name == "keys")
+            ok = ParseNumber(value, options.keys);
+        else if (name == "dist")
+            options.zipf = value == "zipf", ok = options.zipf || value == "uniform";
+        else if (name == "zipf")
+            ok = ParseNumber(value, options.zipfSkew);
+        else if (name == "get-ratio")
+            ok = ParseNumber(value, options.getRatio);
+        else if (name == "value-size")
+            ok = ParseNumber(value, options.valueSize);
+        else
+            ok = false;
+
+        if (!ok)
+            return false;
+    }
+    // value为空时请求变成"SET key \n"，服务端会把下一个请求的命令当成value读走；
+    // bernoulli_distribution的概率必须在[0, 1]内。
+    return options.connections > 0 && options.pipeline > 0 &&
+           options.keys > 0 && options.valueSize > 0 &&
+           options.getRatio >= 0 && options.getRatio <= 1;
+}
+
+// 最长的请求"SET key<编号> <value>\n"的字节数；回复"VALUE <value>\n"更短。
+std::size_t MaxRequestBytes(const Options &options)
+{
+    return std::string_view{ "SET key" }.size() +
+           std::to_string(options.keys - 1).size() + options.valueSize + 2;
+}
+
+// 一轮最多能发多少个请求，至少1个
+int MaxPipeline(const Options &options)
+{
+    return static_cast<int>(
+        std::max<std::size_t>(s_maxBatchBytes / MaxRequestBytes(options), 1));
+}
+
+// 预先算好累积分布，采样时二分查找；第i个key的概率正比于1/(i+1)^s。
+class KeyGenerator
+{
+public:
+    explicit KeyGenerator(const Options &options) : keys_{ options.keys }
+    {
+        if (!options.zipf)
+            return;
+
+        cdf_.resize(keys_);
+        double sum = 0;
+        for (std::size_t i = 0; i < keys_; i++)
+        {
+            sum += 1.0 / std::pow(static_cast<double>(i + 1), options.zipfSkew);
+            cdf_[i] = sum;
+        }
+        for (auto &val : cdf_)
+            val /= sum;
+    }
+
+    std::size_t operator()(std::mt19937_64 &engine) const
+    {
+        if (cdf_.empty())
+            return std::uniform_int_distribution<std::size_t>{ 0, keys_ - 1 }(
+                engine);
+
+        double p = std::uniform_real_distribution<double>{ 0, 1 }(engine);
+        auto it = std::ranges::lower_bound(cdf_, p);
+        return std::min<std::size_t>(it - cdf_.begin(), keys_ - 1);
+    }
+
+private:
+    std::size_t keys_;
+    std::vector<double> cdf_;
+};
+
+bool Connect(Network::TCPStream &stream, std::uint16_t port)
+{
+    Network::Socket socket{ "127.0.0.1", port, Network::Socket::Tag::Connect };
+    if (!socket)
+        return false;
+    socket.SetNoDelay();
+    stream.open(std::move(socket), 64 * 1024, 64 * 1024);
+    return true;
+}
+
+// 读取一个回复，返回是否成功
+bool ReadReply(Network::TCPStream &stream, std::string &word)
+{
+    if (!(stream >> word))
+        return false;
+    if (word == "VALUE")
+        return static_cast<bool>(stream >> word);
+    return true;
+}
+
+bool Preload(const Options &options, const std::string &value)
+{
+    Network::TCPStream stream;
+    if (!Connect(stream, options.port))
+        return false;
+
+    std::string word;
+    auto batch = std::min<std::size_t>(1024, MaxPipeline(options));
+    for (std::size_t begin = 0; begin < options.keys; begin += batch)
+    {
+        auto end = std::min(options.keys, begin + batch);
+        for (auto i = begin; i < end; i++)
+            stream << "SET key" << i << ' ' << value << '\n';
+        stream.flush();
+        for (auto i = begin; i < end; i++)
+        {
+            if (!ReadReply(stream, word))
+                return false;
+        }
+    }
+    return true;
+}
+
+struct WorkerResult
+{
+    std::int64_t ops = 0;
+    std::vector<std::int64_t> latenciesNs; // 每轮pipeline的往返时间
+    bool ok = true;
+};
+
+void RunWorker(const Options &options, const KeyGenerator &keyGen,
+               const std::string &value, unsigned seed, WorkerResult &result)
+{
+    Network::TCPStream stream;
+    if (!Connect(stream, options.port))
+    {
+        result.ok = false;
+        return;
+    }
+
+    std::mt19937_64 engine{ seed };
+    std::bernoulli_distribution isGet{ options.getRatio };
+    std::string word;
+    result.latenciesNs.reserve(options.requests / options.pipeline + 1);
+
+    for (std::int64_t sent = 0; sent < options.requests;)
+    {
+        auto batch = std::min<std::int64_t>(options.pipeline,
+                                            options.requests - sent);
+        auto start = Clock::now();
+        for (std::int64_t i = 0; i < batch; i++)
+        {
+            auto key = keyGen(engine);
+            if (isGet(engine))
+                stream << "GET key" << key << '\n';
+            else
+                stream << "SET key" << key << ' ' << value << '\n';
+        }
+        stream.flush();
+
+        for (std::int64_t i = 0; i < batch; i++)
+        {
+            if (!ReadReply(stream, word))
+            {
+                result.ok = false;
+                return;
+            }
+        }
+        result.latenciesNs.push_back(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                                 start)
+                .count());
+        sent += batch, result.ops += batch;
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        std::println("Invalid arguments, see the comment at the top of "
+                     "kv_client.cpp for usage.");
+        return 1;
+    }
+
+    if (auto maxPipeline = MaxPipeline(options); options.pipeline > maxPipeline)
+    {
+        std::println("pipeline={} does not fit in {} bytes, using {}",
+                     options.pipeline, s_maxBatchBytes, maxPipeline);
+        options.pipeline = maxPipeline;
+    }
+
+    Network::Startup();
+    std::string value(options.valueSize, 'v');
+    if (!Preload(options, value))
+    {
+        std::println("Preload error: {}", Network::GetErrorCode());
+        return 1;
+    }
+
+    KeyGenerator keyGen{ options };
+    std::vector<WorkerResult> results(options.connections);
+    auto start = Clock::now();
+    {
+        std::vector<std::jthread> workers;
+        for (int i = 0; i < options.connections; i++)
+        {
+            workers.emplace_back(RunWorker, std::cref(options), std::cref(keyGen),
+                                 std::cref(value), static_cast<unsigned>(i + 1),
+                                 std::ref(results[i]));
+        }
+    }
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+
+    std::int64_t totalOps = 0;
+    std::vector<std::int64_t> latencies;
+    for (auto &result : results)
+    {
+        if (!result.ok)
+        {
+            std::println("A connection failed: {}", Network::GetErrorCode());
+            return 1;
+        }
+        totalOps += result.ops;
+        latencies.insert(latencies.end(), result.latenciesNs.begin(),
+                         result.latenciesNs.end());
+    }
+    std::ranges::sort(latencies);
+    auto percentile = [&latencies](double p) {
+        if (latencies.empty())
+            return 0.0;
+        auto idx = static_cast<std::size_t>(p * (latencies.size() - 1));
+        return latencies[idx] / 1000.0;
+    };
+
+    std::println("connections={} pipeline={} keys={} dist={} get-ratio={}",
+                 options.connections, options.pipeline, options.keys,
+                 options.zipf ? "zipf" : "uniform", options.getRatio);
+    std::println("ops={} time={:.3f}s throughput={:.0f} ops/s", totalOps,
+                 elapsed.count(), totalOps / elapsed.count());
+    std::println("batch rtt(us): p50={:.1f} p99={:.1f} p999={:.1f} max={:.1f}",
+                 percentile(0.5), percentile(0.99), percentile(0.999),
+                 percentile(1.0));
+    return 0;
+}
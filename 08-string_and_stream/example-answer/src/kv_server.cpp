@@ -0,0 +1,103 @@
+#include "KVStore.h"
+#include "TCPStream.h"
+#include <charconv>
+#include <limits>
+#include <print>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// 协议：以空白分隔，一行一个请求。
+//   GET key        -> VALUE value | NOT_FOUND
+//   SET key value  -> OK
+//   DEL key        -> DELETED | NOT_FOUND
+// 客户端可以连续发送多个请求（pipeline），服务器按顺序回复；只有当输入缓冲区
+// 和socket里都没有待处理的请求时才flush，这样一批请求的回复只需一次send。
+
+namespace
+{
+
+constexpr std::streamsize s_bufferSize = 16 * 1024;
+
+void Serve(Network::Socket socket, KV::ShardedStore &store)
+{
+    socket.SetNoDelay();
+    Network::TCPStream stream;
+    stream.open(std::move(socket), s_bufferSize, s_bufferSize);
+
+    std::string cmd, key, value;
+    while (stream >> cmd >> key)
+    {
+        if (cmd == "GET")
+        {
+            if (auto result = store.Get(key))
+                stream << "VALUE " << *result << '\n';
+            else
+                stream << "NOT_FOUND\n";
+        }
+        else if (cmd == "SET")
+        {
+            if (!(stream >> value))
+                break;
+            store.Set(key, value);
+            stream << "OK\n";
+        }
+        else if (cmd == "DEL")
+        {
+            stream << (store.Del(key) ? "DELETED\n" : "NOT_FOUND\n");
+        }
+        else
+        {
+            stream << "ERROR\n";
+        }
+
+        // 吃掉行尾，否则缓冲区里总留着一个'\n'，in_avail永远不为0。
+        stream.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        if (stream.rdbuf()->in_avail() <= 0)
+            stream.flush();
+    }
+}
+
+template<typename T>
+T ParseArg(int argc, char **argv, int idx, T defaultValue)
+{
+    if (idx >= argc)
+        return defaultValue;
+    std::string_view arg{ argv[idx] };
+    T result{};
+    auto [ptr, ec] = std::from_chars(arg.data(), arg.data() + arg.size(), result);
+    return ec == std::errc{} ? result : defaultValue;
+}
+
+} // namespace
+
+// 用法：kv_server [port] [shardNum]
+int main(int argc, char **argv)
+{
+    auto port = ParseArg<std::uint16_t>(argc, argv, 1, 34568);
+    auto shardNum = ParseArg<std::size_t>(argc, argv, 2, 64);
+
+    Network::Startup();
+    Network::Socket listenSock{ "127.0.0.1", port,
+                                Network::Socket::Tag::Listen };
+    if (!listenSock)
+    {
+        std::println("Listen socket error: {}", Network::GetErrorCode());
+        return 1;
+    }
+
+    KV::ShardedStore store{ shardNum };
+    std::println("KV server listening on 127.0.0.1:{} with {} shards", port,
+                 store.GetShardNum());
+    while (true)
+    {
+        Network::Socket acceptSock{ listenSock, Network::Socket::Tag::Accept };
+        if (!acceptSock)
+        {
+            std::println("Accept socket error: {}", Network::GetErrorCode());
+            return 1;
+        }
+        // 每个连接一个线程；store活到进程结束，分离线程是安全的。
+        std::thread{ Serve, std::move(acceptSock), std::ref(store) }.detach();
+    }
+}
@@ -3,6 +3,8 @@
 #include <print>
 #include <string_view>
 
+using namespace std::chrono_literals;
+
 int main()
 {
     Network::Startup();
@@ -21,10 +23,18 @@ int main()
 
     Network::ITCPStream stream;
     stream.open(std::move(acceptSock), 4);
+    // 对端卡住时不要永远阻塞在recv上
+    stream.rdbuf()->SetTimeout(30s);
     std::string str;
     while (stream >> str)
     {
         std::cout << str << std::endl;
     }
+
+    if (auto error = stream.rdbuf()->GetError())
+    {
+        std::println("Recv error: {}", error.message());
+        return 1;
+    }
     return 0;
 }
\ No newline at end of file
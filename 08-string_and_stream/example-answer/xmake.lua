@@ -16,4 +16,12 @@ target("server")
 
 target("client")
     add_deps("TCPStream")
-    add_files("src/client.cpp")
\ No newline at end of file
+    add_files("src/client.cpp")
+
+target("kv_server")
+    add_deps("TCPStream")
+    add_files("src/kv_server.cpp")
+
+target("kv_client")
+    add_deps("TCPStream")
+    add_files("src/kv_client.cpp")
@@ -4,6 +4,7 @@
 #include <shared_mutex>
 #include <map>
 #include <string>
+#include "Settings.h"
 
 class Settings {
 private:
@@ -25,12 +26,18 @@ public:
 
 Settings set;
 
+// 读者不加锁的版本：写者复制整张表后整体替换，读者通过自己的 reader 读快照，返回 string_view 不复制
+rcu_settings rcu_set;
+
 void read(){
     (void)set.get("1");
+    auto reader = rcu_set.make_reader();
+    (void)reader.get("1");
 }
 
 void write(){
     set.set("1", "a");
+    rcu_set.set("1", "a");
 }
 
 int main(){
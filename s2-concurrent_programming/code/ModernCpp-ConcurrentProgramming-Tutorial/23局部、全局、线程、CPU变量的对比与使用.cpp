@@ -1,5 +1,7 @@
 #include <iostream>
 #include <thread>
+#include <vector>
+#include "ShardedCounter.h"
 
 thread_local int n = (std::puts("thread_local init"), 0);
 
@@ -12,6 +14,25 @@ void f2(){
     thread_local static int n = (std::puts("f2 init"), 0);
 }
 
+// 可复用的版本：线程变量做计数器时，每个线程的槽位登记在计数器里，读的时候汇总；
+// CPU 变量则按当前所在的 CPU 选槽位。全局的 atomic 计数器被所有线程争抢，这两种都不会
+sharded_counter thread_hits;
+per_cpu_counter cpu_hits;
+
+void counters(){
+    std::vector<std::jthread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([] {
+            for (int j = 0; j < 1000; ++j) {
+                thread_hits.add();
+                cpu_hits.add();
+            }
+        });
+    }
+    threads.clear();
+    std::cout << thread_hits.read() << ' ' << cpu_hits.read() << '\n';
+}
+
 int main(){
     (void)n; // 防止 gcc 与 clang 优化
     std::cout << "main\n";
@@ -19,6 +40,7 @@ int main(){
     f2();
     f2();
     f2();
+    counters();
 }
 
 // gcc 与 clang 存在优化，会出现与 msvc 不同的结果，它们直接将线程变量优化掉了
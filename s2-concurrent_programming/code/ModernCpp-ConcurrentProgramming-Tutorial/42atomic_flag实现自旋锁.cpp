@@ -2,19 +2,12 @@
 #include <atomic>
 #include <mutex>
 #include <thread>
+#include "SpinLock.h"
 
-class spinlock_mutex {
-    std::atomic_flag flag{};
-public:
-    spinlock_mutex()noexcept = default;
-    void lock()noexcept {
-        while (flag.test_and_set(std::memory_order_acquire));
-    }
-
-    void unlock()noexcept {
-        flag.clear(std::memory_order_release);
-    }
-};
+// spinlock_mutex 在 SpinLock.h 中：最简单的写法是 while (flag.test_and_set(std::memory_order_acquire));
+// 但每次 test_and_set 都是写操作，等待的线程会让缓存行在各个核之间来回传递，
+// 所以先用 flag.test() 只读地等锁释放再去抢（TTAS），抢失败了还要退避。
+// 线程多于核数、临界区又长时用 adaptive_mutex：自旋一小段还拿不到锁就睡眠。
 
 spinlock_mutex m;
 
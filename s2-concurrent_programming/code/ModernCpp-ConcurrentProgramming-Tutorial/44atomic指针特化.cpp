@@ -1,4 +1,5 @@
 #include <iostream>
+#include "LockFreeStack.h"
 
 struct X{
     int v{};
@@ -7,6 +8,21 @@ struct X{
     }
 };
 
+// atomic<T*> 的 compare_exchange 是无锁栈的基础：push 把新节点的 next 指向当前栈顶，再用 CAS 换栈顶，
+// 失败时 compare_exchange_weak 会把最新的栈顶写回 n->next，重试即可。
+// pop 只用裸指针会有 ABA 问题，完整的实现（带版本号的栈顶、节点回收）见 LockFreeStack.h
+struct Node {
+    int   v;
+    Node* next;
+};
+
+std::atomic<Node*> head{ nullptr };
+
+void push(int v) {
+    Node* n = new Node{ v, head.load() };
+    while (!head.compare_exchange_weak(n->next, n)) {}
+}
+
 int main(){
     int arr[10]{ 1,2 };
 
@@ -29,4 +45,12 @@ int main(){
     p2.load()->f();
     p2 += 2;
     p2.load()->f();
+
+    push(1);
+    push(2);
+    std::cout << head.load()->v << ' ' << head.load()->next->v << '\n';
+
+    treiber_stack<int> stack;
+    stack.push(3);
+    std::cout << stack.pop().value_or(0) << '\n';
 }
\ No newline at end of file
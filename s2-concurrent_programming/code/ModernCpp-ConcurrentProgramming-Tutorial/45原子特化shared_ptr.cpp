@@ -3,6 +3,7 @@
 #include <thread>
 #include <chrono>
 #include <syncstream>
+#include "EpochReclamation.h"
 using namespace std::chrono_literals;
 
 class Data {
@@ -36,6 +37,24 @@ void reader() {
     }
 }
 
+// 读者不改引用计数的版本：旧对象交给纪元域回收，读取是等待无关的
+atomic_snapshot<Data> snapshot_data;
+
+void snapshot_writer() {
+    for (int i = 0; i < 10; ++i) {
+        snapshot_data.store(Data{ i });
+        std::this_thread::sleep_for(100ms);
+    }
+}
+
+void snapshot_reader() {
+    for (int i = 0; i < 10; ++i) {
+        int value = snapshot_data.read([](const Data& d) { return d.get_value(); });
+        std::cout << "读取线程值: " << value << std::endl;
+        std::this_thread::sleep_for(100ms);
+    }
+}
+
 std::atomic<std::shared_ptr<int>> ptr = std::make_shared<int>();
 
 void wait_for_wake_up() {
@@ -68,6 +87,11 @@ int main() {
     //writer_thread.join();
     //reader_thread.join();
 
+    //std::thread snapshot_writer_thread{ snapshot_writer };
+    //std::thread snapshot_reader_thread{ snapshot_reader };
+    //snapshot_writer_thread.join();
+    //snapshot_reader_thread.join();
+
     //std::atomic<std::shared_ptr<int>> ptr = std::make_shared<int>(10);
     //std::atomic_ref<int> ref{ *ptr.load() };
     //ref = 100; // 原子地赋 100 给被引用的对象
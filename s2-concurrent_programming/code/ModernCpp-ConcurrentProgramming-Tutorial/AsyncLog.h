@@ -0,0 +1,450 @@
+#pragma once
+
+#include <spdlog/spdlog.h>
+#include <spdlog/details/log_msg.h>
+#include <spdlog/details/os.h>
+#include <spdlog/sinks/sink.h>
+#include <spdlog/fmt/fmt.h>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// 异步日志后端：调用线程只把参数按二进制原样写进自己的缓冲区，格式化和写文件/控制台交给后台线程。
+//
+// spdlog 的同步 logger 每条日志都在调用线程里格式化、加 sink 的互斥量、做 I/O，几微秒到几十微秒，
+// 多个线程同时打日志还要排队。这里的热路径是：检查级别、取一次时间、把参数 memcpy 进本线程的环形缓冲区，
+// 发布一次下标，大约几十纳秒，不加锁、不分配内存。
+//
+//   - 每个线程第一次打日志时登记一个单生产者单消费者的字节环形缓冲区，线程退出后由后台线程写完再释放；
+//   - 一条记录是：记录头（格式化函数、调用位置、格式字符串、时间）+ 编码后的参数。
+//     算术类型、枚举、指针按字节复制，字符串（const char*/std::string/std::string_view）复制长度和内容，
+//     其它类型要求可平凡复制，否则请先转成字符串；
+//   - 后台线程轮询所有缓冲区，一批批地取出记录、格式化，直接交给 logger 的各个 sink，空闲时 flush。
+//     时间、线程号和调用位置都是调用时记下的，输出和同步 logger 一样；
+//   - 缓冲区满了默认等待后台线程腾出空间（不丢日志），也可以选择丢弃并计数。
+//
+//     ASYNC_LOG_INFO("连接 {} 来自 {}:{}", id, host, port);
+//     async_logger::instance().flush();   // 等到此前的日志都写出去
+//
+// 字面量格式字符串和 spdlog 一样在编译期检查，记录里只存它的地址；用 fmt::runtime(...) 包起来的运行期
+// 字符串要到后台线程格式化时才检查，内容会复制进记录，调用返回后就可以释放。
+// 进程退出时（async_logger 析构）会写完剩下的日志。
+
+struct async_log_site {
+    spdlog::level::level_enum level;
+    const char*               file;
+    int                       line;
+    const char*               function;
+};
+
+namespace detail {
+
+// 参数的编码方式：默认按字节复制
+template<typename T>
+struct log_arg {
+    static_assert(std::is_trivially_copyable_v<T>, "异步日志的参数要可平凡复制，其它类型请先转成字符串");
+    using stored = T;
+
+    static std::size_t size(const T&) noexcept { return sizeof(T); }
+    static std::byte* encode(std::byte* out, const T& value) noexcept {
+        std::memcpy(out, &value, sizeof(T));
+        return out + sizeof(T);
+    }
+    static T decode(const std::byte*& in) noexcept {
+        T value;
+        std::memcpy(&value, in, sizeof(T));
+        in += sizeof(T);
+        return value;
+    }
+};
+
+// 字符串复制长度和内容，解码成指向缓冲区的 string_view
+struct log_string_arg {
+    using stored = std::string_view;
+
+    static std::size_t size(std::string_view s) noexcept { return sizeof(std::uint32_t) + s.size(); }
+    static std::byte* encode(std::byte* out, std::string_view s) noexcept {
+        auto n = static_cast<std::uint32_t>(s.size());
+        std::memcpy(out, &n, sizeof(n));
+        std::memcpy(out + sizeof(n), s.data(), n);
+        return out + sizeof(n) + n;
+    }
+    static std::string_view decode(const std::byte*& in) noexcept {
+        std::uint32_t n;
+        std::memcpy(&n, in, sizeof(n));
+        std::string_view s{ reinterpret_cast<const char*>(in + sizeof(n)), n };
+        in += sizeof(n) + n;
+        return s;
+    }
+};
+
+template<> struct log_arg<const char*> : log_string_arg {};
+template<> struct log_arg<char*> : log_string_arg {};
+template<> struct log_arg<std::string> : log_string_arg {};
+template<> struct log_arg<std::string_view> : log_string_arg {};
+
+template<typename T>
+using log_arg_t = log_arg<std::decay_t<T>>;
+
+using log_format_fn = void (*)(const std::byte* args, fmt::string_view format, spdlog::memory_buf_t& out);
+
+// 每种参数组合实例化一个，后台线程用它把参数解码回来再格式化
+template<typename... Args>
+void format_log_record([[maybe_unused]] const std::byte* args, fmt::string_view format, spdlog::memory_buf_t& out) {
+    // 花括号里的初始化按从左到右的顺序求值，正好是编码的顺序
+    std::tuple<typename log_arg<Args>::stored...> values{ log_arg<Args>::decode(args)... };
+    std::apply([&](const auto&... v) {
+        fmt::vformat_to(std::back_inserter(out), format, fmt::make_format_args(v...));
+    }, values);
+}
+
+using log_runtime_format = decltype(fmt::runtime(fmt::string_view{}));
+
+// 记录的开头。大小是 16 的倍数，缓冲区末尾放不下一整条时写一个 format == nullptr 的填充记录，从头开始。
+// format_data 为空时格式字符串复制在记录头后面、参数前面，共 format_size 字节
+struct log_record_header {
+    std::uint32_t         size;
+    log_format_fn         format;
+    const async_log_site* site;
+    const char*           format_data;
+    std::size_t           format_size;
+    std::int64_t          time; // spdlog::log_clock 的 tick
+};
+
+inline constexpr std::size_t log_record_align = 16;
+
+constexpr std::size_t log_align_up(std::size_t n) noexcept {
+    return (n + log_record_align - 1) & ~(log_record_align - 1);
+}
+
+// 一个线程的日志缓冲区：单生产者（所属线程）单消费者（后台线程）的字节环形缓冲区
+class log_thread_buffer {
+public:
+    log_thread_buffer(std::size_t capacity, std::size_t thread_id) :
+        capacity_{ std::bit_ceil(std::max<std::size_t>(capacity, 4096)) },
+        data_{ std::make_unique<std::uint64_t[]>(capacity_ / sizeof(std::uint64_t)) },
+        thread_id_{ thread_id } {}
+
+    // 生产者：预留 n 字节（已对齐）的连续空间，空间不够时返回 nullptr
+    std::byte* reserve(std::size_t n) noexcept {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        std::size_t contiguous = capacity_ - (tail & (capacity_ - 1));
+        std::size_t needed = contiguous < n ? contiguous + n : n;
+        if (capacity_ - (tail - cached_head_) < needed) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (capacity_ - (tail - cached_head_) < needed)
+                return nullptr;
+        }
+        if (contiguous < n) {
+            auto* pad = reinterpret_cast<log_record_header*>(bytes() + (tail & (capacity_ - 1)));
+            pad->size = static_cast<std::uint32_t>(contiguous);
+            pad->format = nullptr;
+            tail += contiguous;
+        }
+        reserved_tail_ = tail;
+        return bytes() + (tail & (capacity_ - 1));
+    }
+
+    void commit(std::size_t n) noexcept {
+        tail_.store(reserved_tail_ + n, std::memory_order_release);
+    }
+
+    // 消费者：对每条记录调用 f(header, args)，返回取出的记录数
+    template<typename F>
+    std::size_t consume(F&& f) {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        std::size_t tail = tail_.load(std::memory_order_acquire);
+        std::size_t count = 0;
+        while (head != tail) {
+            auto* header = reinterpret_cast<const log_record_header*>(bytes() + (head & (capacity_ - 1)));
+            if (header->format) {
+                f(*header, reinterpret_cast<const std::byte*>(header) + sizeof(log_record_header));
+                ++count;
+            }
+            head += header->size;
+        }
+        head_.store(head, std::memory_order_release); // 一批只发布一次
+        return count;
+    }
+
+    bool empty() const noexcept {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    std::size_t capacity() const noexcept { return capacity_; }
+    std::size_t thread_id() const noexcept { return thread_id_; }
+
+    std::atomic<bool>          closed{ false };  // 线程已经退出
+    std::atomic<std::uint64_t> dropped{ 0 };     // 只有生产者写
+
+private:
+    std::byte* bytes() noexcept { return reinterpret_cast<std::byte*>(data_.get()); }
+
+    std::size_t                      capacity_;
+    std::unique_ptr<std::uint64_t[]> data_; // 按 8 字节对齐
+    std::size_t                      thread_id_;
+
+    alignas(64) std::atomic<std::size_t> tail_{ 0 };
+    std::size_t cached_head_ = 0;   // 以下两个只有生产者访问
+    std::size_t reserved_tail_ = 0;
+    alignas(64) std::atomic<std::size_t> head_{ 0 };
+};
+
+} // namespace detail
+
+// async_logger::log 的格式字符串参数。字面量（编译期常量）走 consteval 的构造函数，在编译期检查并且
+// 一直有效；fmt::runtime(...) 的内容可能在后台线程用到之前就释放了，标记为需要复制
+template<typename... Args>
+class async_format_string {
+public:
+    template<typename S>
+        requires std::is_convertible_v<const S&, fmt::string_view>
+    consteval async_format_string(const S& s) : view_{ s } {
+        [[maybe_unused]] fmt::format_string<Args...> check{ s }; // 和 spdlog 一样检查格式说明与参数
+    }
+
+    async_format_string(detail::log_runtime_format s) noexcept : view_{ s.str }, copy_{ true } {}
+
+    fmt::string_view view() const noexcept { return view_; }
+    bool copy() const noexcept { return copy_; }
+
+private:
+    fmt::string_view view_;
+    bool             copy_ = false;
+};
+
+struct async_log_options {
+    std::size_t               buffer_bytes    = std::size_t{ 1 } << 20; // 每个线程
+    bool                      block_when_full = true;                  // false 时缓冲区满了丢弃并计数
+    std::chrono::microseconds poll_interval{ 500 };                    // 后台线程空闲时的轮询间隔
+};
+
+class async_logger {
+public:
+    using options = async_log_options;
+
+    // 输出到 logger 的各个 sink（沿用它们的级别和格式），不经过 logger 本身
+    explicit async_logger(std::shared_ptr<spdlog::logger> logger, options opts = {}) :
+        logger_{ std::move(logger) }, sinks_{ logger_->sinks() }, options_{ opts },
+        level_{ static_cast<int>(logger_->level()) },
+        backend_{ [this](std::stop_token stop) { run(stop); } } {}
+
+    ~async_logger() {
+        backend_.request_stop();
+        backend_.join();
+    }
+
+    async_logger(const async_logger&) = delete;
+    async_logger& operator=(const async_logger&) = delete;
+
+    // 第一次调用时创建，输出到 spdlog 的默认 logger（Log.h 里设置成了 multi_sink）
+    static async_logger& instance() {
+        static async_logger logger{ spdlog::default_logger() };
+        return logger;
+    }
+
+    template<typename... Args>
+    void log(const async_log_site& site, async_format_string<std::type_identity_t<Args>...> format, Args&&... args) {
+        if (static_cast<int>(site.level) < level_.load(std::memory_order_relaxed))
+            return;
+        fmt::string_view fmt_view = format.view();
+        std::size_t copied = format.copy() ? fmt_view.size() : 0;
+        std::size_t size = detail::log_align_up(sizeof(detail::log_record_header) + copied + (std::size_t{ 0 } + ... + detail::log_arg_t<Args>::size(args)));
+        auto& buffer = local();
+        if (size > buffer.capacity() / 2) {
+            buffer.dropped.store(buffer.dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return;
+        }
+        std::byte* out = buffer.reserve(size);
+        while (!out) {
+            if (!options_.block_when_full) {
+                buffer.dropped.store(buffer.dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return;
+            }
+            std::this_thread::yield();
+            out = buffer.reserve(size);
+        }
+        auto* header = reinterpret_cast<detail::log_record_header*>(out);
+        header->size = static_cast<std::uint32_t>(size);
+        header->format = &detail::format_log_record<std::decay_t<Args>...>;
+        header->site = &site;
+        header->format_data = copied ? nullptr : fmt_view.data();
+        header->format_size = fmt_view.size();
+        header->time = spdlog::log_clock::now().time_since_epoch().count();
+        [[maybe_unused]] std::byte* p = out + sizeof(detail::log_record_header);
+        if (copied) {
+            std::memcpy(p, fmt_view.data(), copied);
+            p += copied;
+        }
+        ((p = detail::log_arg_t<Args>::encode(p, args)), ...);
+        buffer.commit(size);
+    }
+
+    void set_level(spdlog::level::level_enum level) noexcept {
+        level_.store(static_cast<int>(level), std::memory_order_relaxed);
+    }
+
+    // 等到调用之前（所有线程）写入的日志都交给 sink 并 flush
+    void flush() {
+        std::uint64_t request = flush_requested_.fetch_add(1, std::memory_order_acq_rel) + 1;
+        for (std::uint64_t done = flush_done_.load(std::memory_order_acquire); done < request;
+             done = flush_done_.load(std::memory_order_acquire))
+            flush_done_.wait(done, std::memory_order_acquire);
+    }
+
+    // 因为缓冲区满或者记录太大丢掉的条数
+    std::uint64_t dropped() const {
+        std::lock_guard<std::mutex> lc{ buffers_mutex_ };
+        std::uint64_t n = dropped_;
+        for (const auto& b : buffers_)
+            n += b->dropped.load(std::memory_order_relaxed);
+        return n;
+    }
+
+private:
+    using buffer_ptr = std::shared_ptr<detail::log_thread_buffer>;
+
+    // 线程退出时把缓冲区标记为关闭，后台线程写完后释放
+    struct thread_handle {
+        buffer_ptr buffer;
+        ~thread_handle() {
+            if (buffer)
+                buffer->closed.store(true, std::memory_order_release);
+        }
+    };
+
+    detail::log_thread_buffer& local() {
+        thread_local thread_handle handle;
+        if (!handle.buffer) [[unlikely]] {
+            handle.buffer = std::make_shared<detail::log_thread_buffer>(options_.buffer_bytes, spdlog::details::os::thread_id());
+            std::lock_guard<std::mutex> lc{ buffers_mutex_ };
+            buffers_.push_back(handle.buffer);
+            buffers_version_.fetch_add(1, std::memory_order_release);
+        }
+        return *handle.buffer;
+    }
+
+    void run(std::stop_token stop) {
+        std::vector<buffer_ptr> buffers;
+        std::uint64_t version = 0;
+        spdlog::memory_buf_t text;
+        bool unflushed = false;
+        for (;;) {
+            bool stopping = stop.stop_requested();
+            std::uint64_t request = flush_requested_.load(std::memory_order_acquire);
+            if (buffers_version_.load(std::memory_order_acquire) != version) {
+                std::lock_guard<std::mutex> lc{ buffers_mutex_ };
+                buffers = buffers_;
+                version = buffers_version_.load(std::memory_order_relaxed);
+            }
+
+            std::size_t written = 0;
+            bool closed_any = false;
+            for (auto& buffer : buffers) {
+                bool closed = buffer->closed.load(std::memory_order_acquire); // 先读关闭标志，之后取完的就是全部
+                written += buffer->consume([&](const detail::log_record_header& header, const std::byte* args) {
+                    write(header, args, buffer->thread_id(), text);
+                });
+                closed_any |= closed;
+            }
+            if (closed_any)
+                remove_closed();
+            if (written != 0)
+                unflushed = true;
+
+            if (unflushed && (written == 0 || request != flush_served_ || stopping)) {
+                for (auto& sink : sinks_)
+                    sink->flush();
+                unflushed = false;
+            }
+            if (request != flush_served_) {
+                flush_served_ = request;
+                flush_done_.store(request, std::memory_order_release);
+                flush_done_.notify_all();
+            }
+            if (stopping)
+                return;
+            if (written == 0)
+                std::this_thread::sleep_for(options_.poll_interval);
+        }
+    }
+
+    void write(const detail::log_record_header& header, const std::byte* args, std::size_t thread_id, spdlog::memory_buf_t& text) {
+        fmt::string_view format{ header.format_data, header.format_size };
+        if (!header.format_data) { // 复制在记录里的运行期格式字符串
+            format = { reinterpret_cast<const char*>(args), header.format_size };
+            args += header.format_size;
+        }
+        text.clear();
+        try {
+            header.format(args, format, text);
+        }
+        catch (const std::exception& e) { // 格式说明和参数不匹配之类，只在运行期才知道
+            text.clear();
+            fmt::format_to(std::back_inserter(text), "[日志格式化失败: {}] {}", e.what(), std::string_view{ format.data(), format.size() });
+        }
+        const async_log_site& site = *header.site;
+        spdlog::details::log_msg msg{
+            spdlog::log_clock::time_point{ spdlog::log_clock::duration{ header.time } },
+            spdlog::source_loc{ site.file, site.line, site.function },
+            logger_->name(), site.level, spdlog::string_view_t{ text.data(), text.size() } };
+        msg.thread_id = thread_id;
+        for (auto& sink : sinks_) {
+            if (sink->should_log(site.level))
+                sink->log(msg);
+        }
+    }
+
+    // 关闭并且已经取空的缓冲区从列表里去掉，丢弃计数并入总数
+    void remove_closed() {
+        std::lock_guard<std::mutex> lc{ buffers_mutex_ };
+        std::erase_if(buffers_, [&](const buffer_ptr& b) {
+            if (!b->closed.load(std::memory_order_acquire) || !b->empty())
+                return false;
+            dropped_ += b->dropped.load(std::memory_order_relaxed);
+            return true;
+        });
+        buffers_version_.fetch_add(1, std::memory_order_release);
+    }
+
+    std::shared_ptr<spdlog::logger>    logger_;
+    std::vector<spdlog::sink_ptr>      sinks_;
+    options                            options_;
+    std::atomic<int>                   level_;
+
+    mutable std::mutex                 buffers_mutex_;
+    std::vector<buffer_ptr>            buffers_;
+    std::uint64_t                      dropped_ = 0; // 已经释放的缓冲区丢掉的条数
+    std::atomic<std::uint64_t>         buffers_version_{ 0 };
+
+    std::atomic<std::uint64_t>         flush_requested_{ 0 };
+    std::atomic<std::uint64_t>         flush_done_{ 0 };
+    std::uint64_t                      flush_served_ = 0; // 只有后台线程访问
+
+    std::jthread                       backend_; // 最后一个成员：最后构造、最先析构
+};
+
+#define ASYNC_LOG_AT(level, ...)                                                                            \
+    do {                                                                                                    \
+        static const async_log_site async_log_site_{ level, __FILE__, __LINE__, static_cast<const char*>(__FUNCTION__) }; \
+        async_logger::instance().log(async_log_site_, __VA_ARGS__);                                         \
+    } while (0)
+
+#define ASYNC_LOG_DEBUG(...) ASYNC_LOG_AT(spdlog::level::debug, __VA_ARGS__)
+#define ASYNC_LOG_INFO(...)  ASYNC_LOG_AT(spdlog::level::info, __VA_ARGS__)
+#define ASYNC_LOG_WARN(...)  ASYNC_LOG_AT(spdlog::level::warn, __VA_ARGS__)
+#define ASYNC_LOG_ERROR(...) ASYNC_LOG_AT(spdlog::level::err, __VA_ARGS__)
@@ -0,0 +1,291 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// 分片加锁的并发哈希表：按哈希值分到 2 的幂个分片，每个分片一把读写锁、一张开放寻址（线性探测）的表，
+// 各自扩容。不同分片上的读写互不影响，写吞吐随分片数增长；查找在连续的数组里探测，
+// 比 std::map 逐层跳指针的缓存缺失少得多。
+// 分片按缓存行对齐，相邻分片的锁不会伪共享。
+//
+// 键是 std::string 时默认的哈希和比较都是透明的，可以直接用 string_view/const char* 查找，不构造临时字符串。
+// 值只能在锁内访问，所以 find 返回副本；不想复制时用 visit 在锁内读取。
+
+// 透明的字符串哈希，string/string_view/const char* 得到相同的结果
+struct string_hash {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view s) const noexcept {
+        return std::hash<std::string_view>{}(s);
+    }
+};
+
+namespace detail {
+
+template<typename Key>
+struct default_hash {
+    using type = std::hash<Key>;
+};
+template<>
+struct default_hash<std::string> {
+    using type = string_hash;
+};
+
+} // namespace detail
+
+template<typename Key, typename Value,
+         typename Hash = typename detail::default_hash<Key>::type,
+         typename KeyEqual = std::equal_to<>>
+class concurrent_hash_map {
+public:
+    using key_type    = Key;
+    using mapped_type = Value;
+    using value_type  = std::pair<const Key, Value>;
+
+    explicit concurrent_hash_map(std::size_t shard_count = 64, Hash hash = Hash{}, KeyEqual equal = KeyEqual{}) :
+        shard_bits_{ static_cast<unsigned>(std::bit_width(std::bit_ceil(std::max<std::size_t>(shard_count, 1)) - 1)) },
+        shards_{ std::make_unique<shard[]>(std::size_t{ 1 } << shard_bits_) },
+        hash_{ std::move(hash) }, equal_{ std::move(equal) } {}
+
+    concurrent_hash_map(const concurrent_hash_map&) = delete;
+    concurrent_hash_map& operator=(const concurrent_hash_map&) = delete;
+
+    // 已经有这个键时不修改，返回 false
+    template<typename K, typename V>
+    bool insert(K&& key, V&& value) {
+        auto h = hash_of(key);
+        shard& s = shard_of(h);
+        std::lock_guard<std::shared_mutex> lc{ s.mutex };
+        if (s.table.find(h, key, equal_) != shard_table::npos)
+            return false;
+        s.table.emplace(h, std::forward<K>(key), std::forward<V>(value));
+        return true;
+    }
+
+    // 插入或覆盖，插入了新键时返回 true
+    template<typename K, typename V>
+    bool insert_or_assign(K&& key, V&& value) {
+        auto h = hash_of(key);
+        shard& s = shard_of(h);
+        std::lock_guard<std::shared_mutex> lc{ s.mutex };
+        if (std::size_t i = s.table.find(h, key, equal_); i != shard_table::npos) {
+            s.table.at(i)->second = std::forward<V>(value);
+            return false;
+        }
+        s.table.emplace(h, std::forward<K>(key), std::forward<V>(value));
+        return true;
+    }
+
+    // 在分片的写锁内修改已有的值：update(key, [](Value& v) { ... })，没有这个键时返回 false
+    template<typename K, typename F>
+    bool update(const K& key, F&& f) {
+        auto h = hash_of(key);
+        shard& s = shard_of(h);
+        std::lock_guard<std::shared_mutex> lc{ s.mutex };
+        std::size_t i = s.table.find(h, key, equal_);
+        if (i == shard_table::npos)
+            return false;
+        std::invoke(std::forward<F>(f), s.table.at(i)->second);
+        return true;
+    }
+
+    template<typename K>
+    std::optional<Value> find(const K& key) const {
+        std::optional<Value> result;
+        visit(key, [&](const Value& value) { result.emplace(value); });
+        return result;
+    }
+
+    // 在分片的读锁内读取值：visit(key, [](const Value& v) { ... })，没有这个键时返回 false。
+    // f 里不要再访问这个表，可能和同一分片的写者死锁
+    template<typename K, typename F>
+    bool visit(const K& key, F&& f) const {
+        auto h = hash_of(key);
+        const shard& s = shard_of(h);
+        std::shared_lock<std::shared_mutex> lock{ s.mutex };
+        std::size_t i = s.table.find(h, key, equal_);
+        if (i == shard_table::npos)
+            return false;
+        std::invoke(std::forward<F>(f), s.table.at(i)->second);
+        return true;
+    }
+
+    template<typename K>
+    bool contains(const K& key) const {
+        return visit(key, [](const Value&) {});
+    }
+
+    template<typename K>
+    bool erase(const K& key) {
+        auto h = hash_of(key);
+        shard& s = shard_of(h);
+        std::lock_guard<std::shared_mutex> lc{ s.mutex };
+        std::size_t i = s.table.find(h, key, equal_);
+        if (i == shard_table::npos)
+            return false;
+        s.table.erase(i);
+        return true;
+    }
+
+    // 各分片逐个加锁求和，其它线程同时在修改时只是近似值
+    std::size_t size() const {
+        std::size_t n = 0;
+        for (std::size_t i = 0; i < shard_count(); ++i) {
+            std::shared_lock<std::shared_mutex> lock{ shards_[i].mutex };
+            n += shards_[i].table.size();
+        }
+        return n;
+    }
+
+    std::size_t shard_count() const noexcept {
+        return std::size_t{ 1 } << shard_bits_;
+    }
+
+    // 逐个分片在读锁内遍历，f(const Key&, const Value&)。看到的不是整张表同一时刻的状态
+    template<typename F>
+    void for_each(F&& f) const {
+        for (std::size_t i = 0; i < shard_count(); ++i) {
+            std::shared_lock<std::shared_mutex> lock{ shards_[i].mutex };
+            shards_[i].table.for_each(f);
+        }
+    }
+
+private:
+    // 一个分片内的开放寻址表，只在分片的锁内使用。
+    // 控制字节：0 空，1 删除（墓碑），其余是 0x80 | 哈希的 7 位，比较键之前先比它，绝大多数不相等的槽位不用碰键。
+    // 哈希值和键值对存在一起，扩容时不用重新计算。
+    class shard_table {
+    public:
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+        std::size_t size() const noexcept { return size_; }
+
+        value_type* at(std::size_t i) noexcept { return &*slots_[i].value; }
+        const value_type* at(std::size_t i) const noexcept { return &*slots_[i].value; }
+
+        template<typename K, typename Eq>
+        std::size_t find(std::uint64_t h, const K& key, const Eq& equal) const noexcept {
+            if (slots_.empty())
+                return npos;
+            std::uint8_t tag = tag_of(h);
+            for (std::size_t i = h & mask(); ; i = (i + 1) & mask()) {
+                std::uint8_t c = ctrl_[i];
+                if (c == empty)
+                    return npos;
+                if (c == tag && slots_[i].hash == h && equal(slots_[i].value->first, key))
+                    return i;
+            }
+        }
+
+        // 调用者保证键不存在
+        template<typename K, typename V>
+        void emplace(std::uint64_t h, K&& key, V&& value) {
+            if ((size_ + tombstones_ + 1) * 8 > slots_.size() * 7) // 负载（含墓碑）不超过 7/8
+                rehash((size_ + 1) * 2 > slots_.size() ? std::max<std::size_t>(16, slots_.size() * 2) : slots_.size());
+            std::size_t i = h & mask();
+            while (ctrl_[i] > deleted)
+                i = (i + 1) & mask();
+            if (ctrl_[i] == deleted)
+                --tombstones_;
+            slots_[i].value.emplace(std::piecewise_construct,
+                std::forward_as_tuple(std::forward<K>(key)), std::forward_as_tuple(std::forward<V>(value)));
+            slots_[i].hash = h;
+            ctrl_[i] = tag_of(h);
+            ++size_;
+        }
+
+        void erase(std::size_t i) noexcept {
+            slots_[i].value.reset();
+            // 下一个槽位是空的，说明没有探测序列要经过这里，可以直接标成空而不留墓碑
+            if (ctrl_[(i + 1) & mask()] == empty) {
+                ctrl_[i] = empty;
+            }
+            else {
+                ctrl_[i] = deleted;
+                ++tombstones_;
+            }
+            --size_;
+        }
+
+        template<typename F>
+        void for_each(F& f) const {
+            for (std::size_t i = 0; i < slots_.size(); ++i) {
+                if (ctrl_[i] > deleted)
+                    f(slots_[i].value->first, slots_[i].value->second);
+            }
+        }
+
+    private:
+        static constexpr std::uint8_t empty   = 0;
+        static constexpr std::uint8_t deleted = 1;
+
+        struct slot {
+            std::uint64_t             hash = 0;
+            std::optional<value_type> value;
+        };
+
+        static std::uint8_t tag_of(std::uint64_t h) noexcept {
+            return static_cast<std::uint8_t>(0x80 | (h >> 32 & 0x7f));
+        }
+        std::size_t mask() const noexcept { return slots_.size() - 1; }
+
+        // 搬到 capacity（2 的幂）个槽位的新表，顺便清掉墓碑；活着的键不多时容量不变，只做清理
+        void rehash(std::size_t capacity) {
+            std::vector<std::uint8_t> ctrl(capacity, empty);
+            std::vector<slot> slots(capacity);
+            for (std::size_t i = 0; i < slots_.size(); ++i) {
+                if (ctrl_[i] <= deleted)
+                    continue;
+                std::size_t j = slots_[i].hash & (capacity - 1);
+                while (ctrl[j] != empty)
+                    j = (j + 1) & (capacity - 1);
+                ctrl[j] = ctrl_[i];
+                slots[j].hash = slots_[i].hash;
+                slots[j].value.emplace(std::move(*slots_[i].value)); // pair<const Key, Value> 的键只能复制
+            }
+            ctrl_.swap(ctrl);
+            slots_.swap(slots);
+            tombstones_ = 0;
+        }
+
+        std::vector<std::uint8_t> ctrl_;
+        std::vector<slot>         slots_;
+        std::size_t               size_       = 0;
+        std::size_t               tombstones_ = 0;
+    };
+
+    struct alignas(64) shard {
+        mutable std::shared_mutex mutex;
+        shard_table               table;
+    };
+
+    // 再混合一次：std::hash 对整数是恒等映射，低位直接取模会扎堆
+    template<typename K>
+    std::uint64_t hash_of(const K& key) const {
+        std::uint64_t h = static_cast<std::uint64_t>(hash_(key));
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    shard& shard_of(std::uint64_t h) const noexcept {
+        return shards_[shard_bits_ == 0 ? 0 : h >> (64 - shard_bits_)];
+    }
+
+    unsigned                 shard_bits_;
+    std::unique_ptr<shard[]> shards_;
+    Hash                     hash_;
+    KeyEqual                 equal_;
+};
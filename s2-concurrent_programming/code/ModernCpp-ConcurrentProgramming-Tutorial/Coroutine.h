@@ -0,0 +1,315 @@
+#pragma once
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+// 惰性启动的协程 task<T>：创建时不执行，被 co_await（或 sync_wait）时才开始，
+// 结束时通过对称转移（await_suspend 返回 coroutine_handle）直接恢复等待者，
+// 同步完成的长链条也不会让调用栈增长。配合 ThreadPool::schedule() 切换到工作线程：
+//
+//     task<int> work(ThreadPool& pool) {
+//         co_await pool.schedule();  // 之后的代码在工作线程上执行
+//         co_return 42;
+//     }
+//     int n = sync_wait(work(pool));
+//
+// 和 submit + future 相比没有共享状态和引用计数，也不需要阻塞等待；
+// 和每个任务一个线程/栈相比，挂起的协程只占一个帧。
+// 对称转移依赖编译器把 resume 变成尾调用：GCC 需要开优化（-O2），而且 AddressSanitizer 会关掉这个优化，
+// 此时很长的同步完成链（几万层）仍可能栈溢出。
+
+namespace detail {
+
+// 协程帧分配器：每个线程按 64 字节一档缓存最多 cache_limit 个空闲帧。
+// 帧在哪个线程释放就回到哪个线程的缓存（在线程池里通常就是下一次创建它的那个线程）。
+class frame_allocator {
+public:
+    static constexpr std::size_t granularity = 64;
+    static constexpr std::size_t classes     = 16;  // 最大缓存 1KB 的帧，更大的直接走 operator new
+    static constexpr std::size_t cache_limit = 64;
+
+    static void* allocate(std::size_t size) {
+        std::size_t c = class_of(size);
+        if (c >= classes)
+            return ::operator new(size);
+        free_list& list = cache().lists[c];
+        if (list.head) {
+            free_block* block = list.head;
+            list.head = block->next;
+            --list.count;
+            return block;
+        }
+        return ::operator new((c + 1) * granularity);
+    }
+
+    static void deallocate(void* ptr, std::size_t size) noexcept {
+        std::size_t c = class_of(size);
+        if (c >= classes) {
+            ::operator delete(ptr);
+            return;
+        }
+        free_list& list = cache().lists[c];
+        if (list.count == cache_limit) {
+            ::operator delete(ptr);
+            return;
+        }
+        list.head = ::new (ptr) free_block{ list.head };
+        ++list.count;
+    }
+
+private:
+    struct free_block {
+        free_block* next;
+    };
+    struct free_list {
+        free_block* head  = nullptr;
+        std::size_t count = 0;
+    };
+    struct thread_cache {
+        free_list lists[classes];
+        ~thread_cache() {
+            for (free_list& list : lists) {
+                while (list.head)
+                    ::operator delete(std::exchange(list.head, list.head->next));
+            }
+        }
+    };
+
+    static std::size_t class_of(std::size_t size) noexcept {
+        return (size - 1) / granularity;
+    }
+    static thread_cache& cache() noexcept {
+        thread_local thread_cache instance;
+        return instance;
+    }
+};
+
+class co_promise_base {
+public:
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+
+    struct final_awaiter {
+        bool await_ready() const noexcept { return false; }
+        template<typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> self) const noexcept {
+            std::coroutine_handle<> continuation = self.promise().continuation_;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+        void await_resume() const noexcept {}
+    };
+    final_awaiter final_suspend() const noexcept { return {}; }
+
+    void set_continuation(std::coroutine_handle<> continuation) noexcept {
+        continuation_ = continuation;
+    }
+
+    // 帧从当前线程的缓存里分配；带 size 的 delete 让释放时不需要额外记录大小
+    static void* operator new(std::size_t size) {
+        return frame_allocator::allocate(size);
+    }
+    static void operator delete(void* ptr, std::size_t size) noexcept {
+        frame_allocator::deallocate(ptr, size);
+    }
+
+private:
+    std::coroutine_handle<> continuation_;
+};
+
+template<typename T>
+class co_promise : public co_promise_base {
+public:
+    using value_type = std::conditional_t<std::is_reference_v<T>, std::remove_reference_t<T>*, T>;
+
+    template<typename V>
+        requires std::is_convertible_v<V&&, T>
+    void return_value(V&& value) {
+        if constexpr (std::is_reference_v<T>)
+            result_.template emplace<1>(std::addressof(value));
+        else
+            result_.template emplace<1>(std::forward<V>(value));
+    }
+    void unhandled_exception() noexcept {
+        result_.template emplace<2>(std::current_exception());
+    }
+
+    T result() {
+        if (result_.index() == 2)
+            std::rethrow_exception(std::get<2>(result_));
+        if constexpr (std::is_reference_v<T>)
+            return static_cast<T>(*std::get<1>(result_));
+        else
+            return std::move(std::get<1>(result_));
+    }
+
+private:
+    std::variant<std::monostate, value_type, std::exception_ptr> result_;
+};
+
+template<>
+class co_promise<void> : public co_promise_base {
+public:
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept {
+        exception_ = std::current_exception();
+    }
+    void result() {
+        if (exception_)
+            std::rethrow_exception(exception_);
+    }
+
+private:
+    std::exception_ptr exception_;
+};
+
+} // namespace detail
+
+template<typename T = void>
+class [[nodiscard]] task {
+public:
+    struct promise_type : detail::co_promise<T> {
+        task get_return_object() noexcept {
+            return task{ std::coroutine_handle<promise_type>::from_promise(*this) };
+        }
+    };
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    task() noexcept = default;
+    task(task&& other) noexcept : handle_{ std::exchange(other.handle_, nullptr) } {}
+    task& operator=(task&& other) noexcept {
+        if (this != &other) {
+            if (handle_)
+                handle_.destroy();
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+    ~task() {
+        if (handle_)
+            handle_.destroy();
+    }
+
+    bool valid() const noexcept { return static_cast<bool>(handle_); }
+    bool is_ready() const noexcept { return !handle_ || handle_.done(); }
+
+    // 启动（或等待）这个协程，完成后恢复等待者并取得结果
+    auto operator co_await() && noexcept {
+        struct awaiter : awaiter_base {
+            T await_resume() { return this->handle.promise().result(); }
+        };
+        return awaiter{ { handle_ } };
+    }
+
+    // 只等待完成，不取结果也不重新抛出异常（sync_wait 这类驱动者用）
+    auto when_ready() noexcept {
+        struct awaiter : awaiter_base {
+            void await_resume() const noexcept {}
+        };
+        return awaiter{ { handle_ } };
+    }
+
+    // 完成后取结果，只能调用一次
+    T result() {
+        return handle_.promise().result();
+    }
+
+private:
+    explicit task(handle_type handle) noexcept : handle_{ handle } {}
+
+    struct awaiter_base {
+        handle_type handle;
+
+        bool await_ready() const noexcept { return !handle || handle.done(); }
+        // 对称转移：直接切到被等待的协程，不经过调用栈
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) const noexcept {
+            handle.promise().set_continuation(awaiting);
+            return handle;
+        }
+    };
+
+    handle_type handle_;
+};
+
+namespace detail {
+
+// sync_wait 的驱动协程：等 task 完成后在 final_suspend 里唤醒调用线程。
+// 唤醒在锁内完成，调用线程醒来时驱动协程已经挂起，可以安全销毁。
+class sync_wait_driver {
+public:
+    struct state {
+        std::mutex              mutex;
+        std::condition_variable cv;
+        bool                    done = false;
+
+        void signal() {
+            std::lock_guard<std::mutex> lc{ mutex };
+            done = true;
+            cv.notify_one();
+        }
+        void wait() {
+            std::unique_lock<std::mutex> lock{ mutex };
+            cv.wait(lock, [this] { return done; });
+        }
+    };
+
+    struct promise_type {
+        state* waiter = nullptr;
+
+        sync_wait_driver get_return_object() noexcept {
+            return sync_wait_driver{ std::coroutine_handle<promise_type>::from_promise(*this) };
+        }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        auto final_suspend() const noexcept {
+            struct notifier {
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<promise_type> self) const noexcept {
+                    self.promise().waiter->signal();
+                }
+                void await_resume() const noexcept {}
+            };
+            return notifier{};
+        }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); } // 只等待 when_ready，不会抛出
+    };
+
+    sync_wait_driver(sync_wait_driver&& other) noexcept : handle_{ std::exchange(other.handle_, nullptr) } {}
+    ~sync_wait_driver() {
+        if (handle_)
+            handle_.destroy();
+    }
+
+    void run(state& waiter) {
+        handle_.promise().waiter = &waiter;
+        handle_.resume();
+        waiter.wait();
+    }
+
+private:
+    explicit sync_wait_driver(std::coroutine_handle<promise_type> handle) noexcept : handle_{ handle } {}
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+template<typename T>
+sync_wait_driver make_sync_wait_driver(task<T>& t) {
+    co_await t.when_ready();
+}
+
+} // namespace detail
+
+// 在当前线程启动 t 并阻塞到它完成（可能在别的线程上完成），返回结果或重新抛出异常。
+// 不要在线程池的工作线程里对调度到同一个线程池的 task 调用，和 future.get() 一样可能死锁。
+template<typename T>
+T sync_wait(task<T> t) {
+    detail::sync_wait_driver::state waiter;
+    detail::make_sync_wait_driver(t).run(waiter);
+    return t.result();
+}
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// 本进程可用的 CPU 及其所在的 NUMA 节点、插槽和物理核心。
+// Linux 上从 sched_getaffinity（尊重 taskset/cgroup 的限制）和 /sys/devices/system 读取；
+// 其它平台或读取失败时退化为“一个节点，hardware_concurrency 个各自独立的核心”。
+class cpu_topology {
+public:
+    struct cpu {
+        unsigned id;      // 操作系统的 CPU 编号
+        unsigned node;    // 重新编号后的节点下标，0 .. node_count()-1
+        unsigned package;
+        unsigned core;
+    };
+
+    // 只在第一次调用时探测
+    static const cpu_topology& get() {
+        static const cpu_topology instance;
+        return instance;
+    }
+
+    const std::vector<cpu>& cpus() const noexcept { return cpus_; }
+    std::size_t node_count() const noexcept { return node_count_; }
+
+    std::vector<unsigned> node_cpus(std::size_t node) const {
+        std::vector<unsigned> ids;
+        for (const cpu& c : cpus_) {
+            if (c.node == node)
+                ids.push_back(c.id);
+        }
+        return ids;
+    }
+
+    // CPU 所在节点的下标，未知的 CPU 返回 0
+    std::size_t node_of(unsigned cpu_id) const noexcept {
+        for (const cpu& c : cpus_) {
+            if (c.id == cpu_id)
+                return c.node;
+        }
+        return 0;
+    }
+
+    // 紧凑：先填满一个节点，同一物理核心的超线程相邻，共享缓存最多
+    std::vector<unsigned> compact_order() const {
+        std::vector<cpu> sorted = cpus_;
+        std::sort(sorted.begin(), sorted.end(), [](const cpu& a, const cpu& b) {
+            return std::tie(a.node, a.package, a.core, a.id) < std::tie(b.node, b.package, b.core, b.id);
+        });
+        std::vector<unsigned> order;
+        for (const cpu& c : sorted)
+            order.push_back(c.id);
+        return order;
+    }
+
+    // 分散：在节点之间轮流分配；节点内先占满所有物理核心，再用超线程，内存带宽和缓存总量最大
+    std::vector<unsigned> scatter_order() const {
+        std::vector<std::vector<unsigned>> per_node(node_count_);
+        for (std::size_t n = 0; n < node_count_; ++n) {
+            std::vector<std::pair<unsigned, cpu>> ranked; // (在同一核心中的序号, cpu)
+            for (const cpu& c : cpus_) {
+                if (c.node != n)
+                    continue;
+                unsigned sibling = 0;
+                for (const cpu& other : cpus_) {
+                    if (other.package == c.package && other.core == c.core && other.id < c.id)
+                        ++sibling;
+                }
+                ranked.emplace_back(sibling, c);
+            }
+            std::sort(ranked.begin(), ranked.end(), [](const auto& a, const auto& b) {
+                return std::tie(a.first, a.second.package, a.second.core, a.second.id) <
+                       std::tie(b.first, b.second.package, b.second.core, b.second.id);
+            });
+            for (const auto& [sibling, c] : ranked)
+                per_node[n].push_back(c.id);
+        }
+        std::vector<unsigned> order;
+        for (std::size_t i = 0; order.size() < cpus_.size(); ++i) {
+            for (const auto& ids : per_node) {
+                if (i < ids.size())
+                    order.push_back(ids[i]);
+            }
+        }
+        return order;
+    }
+
+private:
+    cpu_topology() {
+        std::vector<unsigned> allowed = allowed_cpus();
+        std::vector<int> raw_nodes(allowed.size(), 0);
+#if defined(__linux__)
+        namespace fs = std::filesystem;
+        std::error_code ec;
+        for (const auto& entry : fs::directory_iterator{ "/sys/devices/system/node", ec }) {
+            std::string name = entry.path().filename().string();
+            if (name.rfind("node", 0) != 0 || name.size() == 4 || !std::all_of(name.begin() + 4, name.end(), [](unsigned char ch) { return std::isdigit(ch) != 0; }))
+                continue;
+            int node = std::stoi(name.substr(4));
+            for (unsigned id : parse_cpu_list(read_line(entry.path() / "cpulist"))) {
+                auto it = std::find(allowed.begin(), allowed.end(), id);
+                if (it != allowed.end())
+                    raw_nodes[it - allowed.begin()] = node;
+            }
+        }
+#endif
+        // 节点编号可能不连续，只保留有可用 CPU 的节点并重新编号
+        std::vector<int> distinct = raw_nodes;
+        std::sort(distinct.begin(), distinct.end());
+        distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+        node_count_ = std::max<std::size_t>(1, distinct.size());
+
+        for (std::size_t i = 0; i < allowed.size(); ++i) {
+            unsigned id = allowed[i];
+            unsigned node = static_cast<unsigned>(std::lower_bound(distinct.begin(), distinct.end(), raw_nodes[i]) - distinct.begin());
+            unsigned package = 0, core = id;
+#if defined(__linux__)
+            std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(id) + "/topology/";
+            package = read_number(base + "physical_package_id", package);
+            core = read_number(base + "core_id", core);
+#endif
+            cpus_.push_back({ id, node, package, core });
+        }
+    }
+
+    static std::vector<unsigned> allowed_cpus() {
+        std::vector<unsigned> ids;
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+            for (unsigned id = 0; id < CPU_SETSIZE; ++id) {
+                if (CPU_ISSET(id, &set))
+                    ids.push_back(id);
+            }
+        }
+#endif
+        if (ids.empty()) {
+            unsigned count = std::max(1u, std::thread::hardware_concurrency());
+            for (unsigned id = 0; id < count; ++id)
+                ids.push_back(id);
+        }
+        return ids;
+    }
+
+    static std::string read_line(const std::filesystem::path& path) {
+        std::ifstream in{ path };
+        std::string line;
+        std::getline(in, line);
+        return line;
+    }
+
+    static unsigned read_number(const std::string& path, unsigned fallback) {
+        std::string line = read_line(path);
+        if (line.empty() || !std::isdigit(static_cast<unsigned char>(line[0])))
+            return fallback;
+        return static_cast<unsigned>(std::stoul(line));
+    }
+
+    // "0-3,8,10-11" 这样的格式
+    static std::vector<unsigned> parse_cpu_list(const std::string& list) {
+        std::vector<unsigned> ids;
+        std::size_t pos = 0;
+        while (pos < list.size() && std::isdigit(static_cast<unsigned char>(list[pos]))) {
+            std::size_t used = 0;
+            unsigned first = static_cast<unsigned>(std::stoul(list.substr(pos), &used));
+            unsigned last = first;
+            pos += used;
+            if (pos < list.size() && list[pos] == '-') {
+                last = static_cast<unsigned>(std::stoul(list.substr(pos + 1), &used));
+                pos += used + 1;
+            }
+            for (unsigned id = first; id <= last; ++id)
+                ids.push_back(id);
+            if (pos < list.size() && list[pos] == ',')
+                ++pos;
+        }
+        return ids;
+    }
+
+    std::vector<cpu> cpus_;
+    std::size_t      node_count_ = 1;
+};
+
+// 把当前线程绑定到给定的 CPU 集合上，不支持的平台或失败时返回 false（线程照常运行）
+inline bool pin_current_thread(std::span<const unsigned> cpu_ids) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (unsigned id : cpu_ids) {
+        if (id < CPU_SETSIZE)
+            CPU_SET(id, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu_ids;
+    return false;
+#endif
+}
+
+// 当前线程正在哪个 CPU 上运行，未知时返回 -1。线程没有绑定时结果随时可能过期，只作提示。
+inline int current_cpu() noexcept {
+#if defined(__linux__)
+    return sched_getcpu();
+#else
+    return -1;
+#endif
+}
@@ -0,0 +1,459 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// 基于纪元（epoch）的内存回收，给无锁数据结构用：读者不修改任何共享的引用计数，
+// 从结构里摘下来的节点先 retire，等所有可能还看得到它的读者都离开之后再释放。
+//
+// 域里有一个全局纪元。读者进入临界区时把自己看到的纪元登记下来，离开时撤销；
+// 所有正在临界区里的读者都登记了当前纪元时，纪元才能加一。retire 时给对象记下当时的纪元 e，
+// 纪元到了 e + 2，说明摘下它之前进入的读者全都离开了，可以释放。
+//
+// 每个线程在每个域里有一个登记项，只有自己写，进入/离开临界区各是一次普通的 store（进入时还要一次 fence）。
+// retire 只是追加到本线程的一批里，攒满一批才交给域：没有开后台回收线程时由攒满的线程顺便回收，
+// 开了（start_reclaimer）就由后台线程定期回收，retire 的线程不再做扫描和释放。
+// 有读者一直待在临界区里不出来，纪元就推进不了，retire 的对象会一直堆着。
+//
+//     epoch_domain& domain = epoch_domain::global();
+//     {
+//         epoch_guard guard{ domain };          // 读者：在临界区里读到的节点不会被释放
+//         node* n = head.load(std::memory_order_acquire);
+//         ...
+//     }
+//     domain.retire(old_node);                  // 写者：摘下节点后交给域，之后由域 delete
+//
+// 域对象要比用过它的线程活得长（通常用 global()，或者和线程池一样放在外层）。
+
+class epoch_domain;
+class epoch_guard;
+
+namespace detail {
+
+// 等待释放的一批对象
+struct retired_batch {
+    static constexpr std::size_t capacity = 64;
+
+    struct item {
+        void* ptr;
+        void (*deleter)(void*);
+    };
+
+    item           items[capacity];
+    std::size_t    size  = 0;
+    std::uint64_t  epoch = 0; // 批中最后一个对象 retire 时的纪元
+    retired_batch* next  = nullptr;
+
+    void free() noexcept {
+        for (std::size_t i = 0; i < size; ++i)
+            items[i].deleter(items[i].ptr);
+    }
+};
+
+// 一个线程在一个域里的登记项。线程退出后留给下一个新线程复用，直到域析构才释放
+struct alignas(64) epoch_participant {
+    std::atomic<std::uint64_t> state{ 0 };      // 纪元 << 1 | 是否在临界区里，只有所属线程写
+    std::atomic<bool>          in_use{ false };
+    epoch_participant*         next = nullptr;  // 域里的登记项链表，只增不删
+    unsigned                   nesting = 0;     // 以下只有所属线程访问
+    retired_batch*             open = nullptr;
+};
+
+} // namespace detail
+
+class epoch_domain {
+public:
+    epoch_domain() : id_{ next_id() } {
+        std::lock_guard<std::mutex> lc{ registry_mutex() };
+        live_domains().insert(id_);
+    }
+
+    // 调用时不能还有线程在临界区里，剩下的对象全部直接释放
+    ~epoch_domain() {
+        stop_reclaimer();
+        {
+            std::lock_guard<std::mutex> lc{ registry_mutex() };
+            live_domains().erase(id_);
+        }
+        free_list(pending_.exchange(nullptr, std::memory_order_acquire), true);
+        for (auto* p = participants_.load(std::memory_order_acquire); p;) {
+            auto* next = p->next;
+            if (p->open)
+                free_list(p->open, true);
+            delete p;
+            p = next;
+        }
+    }
+
+    epoch_domain(const epoch_domain&) = delete;
+    epoch_domain& operator=(const epoch_domain&) = delete;
+
+    static epoch_domain& global() {
+        static epoch_domain domain;
+        return domain;
+    }
+
+    // 进入/离开临界区，可以嵌套，必须在同一个线程配对调用。一般用 epoch_guard
+    void enter() {
+        enter(local());
+    }
+    void leave() noexcept {
+        leave(local());
+    }
+
+    // 对象已经从数据结构里摘下（新的读者不会再看到它）之后调用，之后由域调用 deleter 释放。
+    // deleter 是无状态的可调用对象，默认 delete
+    template<typename T, typename Deleter = std::default_delete<T>>
+    void retire(T* ptr, Deleter = Deleter{}) {
+        static_assert(std::is_empty_v<Deleter> && std::is_default_constructible_v<Deleter>,
+            "deleter 不能有状态，需要时用 retire(void*, void(*)(void*))");
+        void (*deleter)(void*) = [](void* p) { Deleter{}(static_cast<T*>(p)); };
+        retire(const_cast<void*>(static_cast<const void*>(ptr)), deleter);
+    }
+
+    void retire(void* ptr, void (*deleter)(void*)) {
+        auto& p = local();
+        if (!p.open)
+            p.open = new detail::retired_batch;
+        // 摘下节点的写入要排在读纪元之前，否则记下的纪元可能偏小
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        p.open->items[p.open->size++] = { ptr, deleter };
+        p.open->epoch = epoch_.load(std::memory_order_relaxed);
+        if (p.open->size == detail::retired_batch::capacity) {
+            seal(p);
+            if (!background_.load(std::memory_order_relaxed))
+                collect();
+        }
+    }
+
+    // 把本线程攒着的对象交给域，并尝试回收。写得很少时（比如配置更新）每次写完调用一次，
+    // 旧对象不用等攒满一批
+    void flush() {
+        auto& p = local();
+        if (p.open && p.open->size != 0)
+            seal(p);
+        if (!background_.load(std::memory_order_relaxed))
+            collect();
+    }
+
+    // 尝试推进纪元，释放已经没有读者的对象。任何线程都可以调用，多个线程同时调用是安全的
+    void collect() {
+        // 临界区里没有读者时，连推两次就能把刚交上来的对象也释放掉
+        for (int i = 0; i < 2 && try_advance(); ++i) {}
+        std::uint64_t epoch = epoch_.load(std::memory_order_acquire);
+
+        detail::retired_batch* list = pending_.exchange(nullptr, std::memory_order_acquire);
+        detail::retired_batch* keep = nullptr;
+        detail::retired_batch* keep_tail = nullptr;
+        while (list) {
+            auto* next = list->next;
+            if (list->epoch + 2 <= epoch) {
+                pending_count_.fetch_sub(list->size, std::memory_order_relaxed);
+                list->free();
+                delete list;
+            }
+            else {
+                list->next = keep;
+                keep = list;
+                if (!keep_tail)
+                    keep_tail = list;
+            }
+            list = next;
+        }
+        if (keep)
+            push(keep, keep_tail);
+    }
+
+    // 开一个后台线程每隔 interval 回收一次，之后 retire 不再顺便回收
+    void start_reclaimer(std::chrono::milliseconds interval = std::chrono::milliseconds{ 10 }) {
+        std::lock_guard<std::mutex> lc{ reclaimer_mutex_ };
+        if (reclaimer_.joinable())
+            return;
+        background_.store(true, std::memory_order_relaxed);
+        reclaimer_ = std::jthread{ [this, interval](std::stop_token stop) {
+            std::mutex m;
+            std::condition_variable_any cv;
+            std::unique_lock<std::mutex> lock{ m };
+            while (!stop.stop_requested()) {
+                collect();
+                cv.wait_for(lock, stop, interval, [] { return false; });
+            }
+        } };
+    }
+
+    void stop_reclaimer() {
+        std::lock_guard<std::mutex> lc{ reclaimer_mutex_ };
+        if (!reclaimer_.joinable())
+            return;
+        reclaimer_.request_stop();
+        reclaimer_.join();
+        reclaimer_ = {};
+        background_.store(false, std::memory_order_relaxed);
+    }
+
+    // 已经交给域、还没释放的对象数（各线程手里没攒满的那一批不算）
+    std::size_t pending() const noexcept {
+        return pending_count_.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t epoch() const noexcept {
+        return epoch_.load(std::memory_order_relaxed);
+    }
+
+private:
+    friend class epoch_guard;
+
+    using participant = detail::epoch_participant;
+
+    void enter(participant& p) {
+        if (p.nesting++ == 0) {
+            // 读到旧的纪元只会让纪元推进得更保守，所以不用 acquire
+            p.state.store(epoch_.load(std::memory_order_relaxed) << 1 | 1, std::memory_order_relaxed);
+            // 登记要在读取数据结构之前被回收者看到，和 try_advance 里的 fence 配对
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+
+    void leave(participant& p) noexcept {
+        if (--p.nesting == 0)
+            p.state.store(p.state.load(std::memory_order_relaxed) & ~std::uint64_t{ 1 }, std::memory_order_release);
+    }
+
+    // 所有在临界区里的线程都登记了当前纪元，才能推进
+    bool try_advance() noexcept {
+        std::uint64_t epoch = epoch_.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        for (auto* p = participants_.load(std::memory_order_acquire); p; p = p->next) {
+            // acquire：读者离开临界区之前的读取都排在之后的释放之前
+            std::uint64_t state = p->state.load(std::memory_order_acquire);
+            if ((state & 1) && (state >> 1) != epoch)
+                return false;
+        }
+        return epoch_.compare_exchange_strong(epoch, epoch + 1, std::memory_order_acq_rel, std::memory_order_relaxed);
+    }
+
+    void seal(participant& p) {
+        pending_count_.fetch_add(p.open->size, std::memory_order_relaxed);
+        push(p.open, p.open);
+        p.open = nullptr;
+    }
+
+    // 只有整条取走（exchange）和压入，没有单个弹出，不存在 ABA 问题
+    void push(detail::retired_batch* first, detail::retired_batch* last) noexcept {
+        auto* head = pending_.load(std::memory_order_relaxed);
+        do {
+            last->next = head;
+        } while (!pending_.compare_exchange_weak(head, first, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    static void free_list(detail::retired_batch* list, bool run_deleters) noexcept {
+        while (list) {
+            auto* next = list->next;
+            if (run_deleters)
+                list->free();
+            delete list;
+            list = next;
+        }
+    }
+
+    // 每个线程记住自己在哪些域里有登记项，线程退出时归还
+    struct thread_registrations {
+        struct entry {
+            std::uint64_t domain_id;
+            epoch_domain* domain;
+            participant*  p;
+        };
+
+        std::uint64_t      last_id = 0; // 最近用过的域，绝大多数线程只用一个域
+        participant*       last = nullptr;
+        std::vector<entry> entries;
+
+        ~thread_registrations() {
+            std::lock_guard<std::mutex> lc{ registry_mutex() };
+            for (auto& e : entries) {
+                if (live_domains().contains(e.domain_id)) // 域已经析构的话登记项也没了
+                    e.domain->detach(*e.p);
+            }
+        }
+    };
+
+    static thread_registrations& registrations() {
+        thread_local thread_registrations instance;
+        return instance;
+    }
+
+    participant& local() {
+        auto& r = registrations();
+        if (r.last_id == id_)
+            return *r.last;
+        return attach(r);
+    }
+
+    participant& attach(thread_registrations& r) {
+        participant* found = nullptr;
+        for (auto& e : r.entries) {
+            if (e.domain_id == id_)
+                found = e.p;
+        }
+        if (!found) {
+            for (auto* p = participants_.load(std::memory_order_acquire); p && !found; p = p->next) {
+                bool expected = false;
+                if (!p->in_use.load(std::memory_order_relaxed) &&
+                    p->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire))
+                    found = p;
+            }
+            if (!found) {
+                found = new participant;
+                found->in_use.store(true, std::memory_order_relaxed);
+                auto* head = participants_.load(std::memory_order_relaxed);
+                do {
+                    found->next = head;
+                } while (!participants_.compare_exchange_weak(head, found, std::memory_order_release, std::memory_order_relaxed));
+            }
+            r.entries.push_back({ id_, this, found });
+        }
+        r.last_id = id_;
+        r.last = found;
+        return *found;
+    }
+
+    // 线程退出：没攒满的一批交给域，登记项留给别的线程
+    void detach(participant& p) noexcept {
+        if (p.open && p.open->size != 0)
+            seal(p);
+        p.nesting = 0;
+        p.state.store(0, std::memory_order_release);
+        p.in_use.store(false, std::memory_order_release);
+    }
+
+    static std::uint64_t next_id() noexcept {
+        static std::atomic<std::uint64_t> id{ 0 };
+        return id.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+    static std::mutex& registry_mutex() {
+        static std::mutex m;
+        return m;
+    }
+    // 还活着的域，线程退出时只归还这些域里的登记项
+    static std::unordered_set<std::uint64_t>& live_domains() {
+        static std::unordered_set<std::uint64_t> ids;
+        return ids;
+    }
+
+    const std::uint64_t                 id_;
+    alignas(64) std::atomic<std::uint64_t> epoch_{ 1 };          // 读者只读，单独一条缓存行
+    alignas(64) std::atomic<detail::retired_batch*> pending_{ nullptr };
+    std::atomic<std::size_t>            pending_count_{ 0 };
+    std::atomic<participant*>           participants_{ nullptr };
+    std::atomic<bool>                   background_{ false };
+    std::mutex                          reclaimer_mutex_;
+    std::jthread                        reclaimer_;
+};
+
+// 临界区：构造时进入，析构时离开，必须在同一个线程里析构。期间读到的节点不会被释放
+class epoch_guard {
+public:
+    explicit epoch_guard(epoch_domain& domain = epoch_domain::global()) : domain_{ domain }, p_{ domain.local() } {
+        domain_.enter(p_);
+    }
+    ~epoch_guard() {
+        domain_.leave(p_);
+    }
+
+    epoch_guard(const epoch_guard&) = delete;
+    epoch_guard& operator=(const epoch_guard&) = delete;
+
+private:
+    epoch_domain&                    domain_;
+    detail::epoch_participant&       p_;
+};
+
+// 读多写少的共享对象：读者不加锁、不改引用计数（对比 std::atomic<std::shared_ptr<T>>），
+// 读取是等待无关（wait-free）的：登记纪元、读一次指针，没有循环。
+// 每次写都分配一个新对象整体替换，旧对象交给纪元域回收，适合很少修改的配置一类的数据。
+//
+//     atomic_snapshot<config> current{ load_config() };
+//     int port = current.read([](const config& c) { return c.port; });
+//     auto c = current.load();                 // 持有期间 c 指向的对象不会被释放
+//     current.update([](config& c) { c.port = 8080; });
+template<typename T>
+class atomic_snapshot {
+public:
+    explicit atomic_snapshot(T value = T{}, epoch_domain& domain = epoch_domain::global()) :
+        value_{ new T(std::move(value)) }, domain_{ domain } {}
+
+    // 调用时不能还有读者
+    ~atomic_snapshot() {
+        delete value_.load(std::memory_order_relaxed);
+    }
+
+    atomic_snapshot(const atomic_snapshot&) = delete;
+    atomic_snapshot& operator=(const atomic_snapshot&) = delete;
+
+    // 在临界区里读当前的值，f 的返回值按值返回（不要返回指向对象内部的引用或指针）
+    template<typename F>
+    auto read(F&& f) const {
+        epoch_guard guard{ domain_ };
+        return std::invoke(std::forward<F>(f), *value_.load(std::memory_order_acquire));
+    }
+
+    // 持有期间对象不会被释放，之后的修改也看不到；只能在创建它的线程里使用和析构
+    class read_guard {
+    public:
+        const T& operator*() const noexcept { return *value_; }
+        const T* operator->() const noexcept { return value_; }
+        const T* get() const noexcept { return value_; }
+
+        read_guard(const read_guard&) = delete;
+        read_guard& operator=(const read_guard&) = delete;
+
+    private:
+        friend class atomic_snapshot;
+        explicit read_guard(const atomic_snapshot& owner) :
+            guard_{ owner.domain_ }, value_{ owner.value_.load(std::memory_order_acquire) } {}
+
+        epoch_guard guard_;
+        const T*    value_;
+    };
+
+    read_guard load() const {
+        return read_guard{ *this };
+    }
+
+    void store(T value) {
+        std::lock_guard<std::mutex> lc{ write_mutex_ };
+        publish(new T(std::move(value)));
+    }
+
+    // 复制当前的值修改后整体替换，写者之间串行
+    template<typename F>
+    void update(F&& modify) {
+        std::lock_guard<std::mutex> lc{ write_mutex_ };
+        T copy = *value_.load(std::memory_order_relaxed);
+        std::invoke(std::forward<F>(modify), copy);
+        publish(new T(std::move(copy)));
+    }
+
+private:
+    void publish(const T* value) {
+        const T* old = value_.exchange(value, std::memory_order_acq_rel);
+        domain_.retire(old);
+        domain_.flush(); // 写很少，每次都推进一下，旧值不用等攒满一批
+    }
+
+    std::atomic<const T*> value_;
+    epoch_domain&         domain_;
+    std::mutex            write_mutex_;
+};
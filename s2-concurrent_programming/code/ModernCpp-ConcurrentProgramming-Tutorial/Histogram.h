@@ -0,0 +1,100 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// 按 2 的幂分桶的耗时直方图：第 0 个桶是 0ns，第 i 个桶是 [2^(i-1), 2^i) 纳秒，
+// 最后一个桶收下所有更长的耗时。分位数只精确到桶，误差在 2 倍以内，换来的是记录一次
+// 只要两个 relaxed 的原子加法，可以一直开着。
+
+struct histogram_snapshot {
+    static constexpr std::size_t bucket_count = 48; // 2^47ns 约 39 小时
+
+    std::array<std::uint64_t, bucket_count> buckets{};
+    std::uint64_t                           count  = 0;
+    std::uint64_t                           sum_ns = 0;
+
+    // 第 i 个桶的上界（不含）
+    static std::chrono::nanoseconds bucket_limit(std::size_t i) noexcept {
+        return std::chrono::nanoseconds{ i == 0 ? 1 : std::int64_t{ 1 } << std::min<std::size_t>(i, 62) };
+    }
+
+    std::chrono::nanoseconds mean() const noexcept {
+        return std::chrono::nanoseconds{ count == 0 ? 0 : static_cast<std::int64_t>(sum_ns / count) };
+    }
+
+    // q 在 [0, 1] 之间，返回第一个累计数量达到 q * count 的桶的上界；没有记录时返回 0
+    std::chrono::nanoseconds percentile(double q) const noexcept {
+        if (count == 0)
+            return std::chrono::nanoseconds{ 0 };
+        auto rank = static_cast<std::uint64_t>(std::clamp(q, 0.0, 1.0) * static_cast<double>(count));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < bucket_count; ++i) {
+            seen += buckets[i];
+            if (seen > rank || seen == count)
+                return bucket_limit(i);
+        }
+        return bucket_limit(bucket_count - 1);
+    }
+
+    histogram_snapshot& operator+=(const histogram_snapshot& other) noexcept {
+        for (std::size_t i = 0; i < bucket_count; ++i)
+            buckets[i] += other.buckets[i];
+        count += other.count;
+        sum_ns += other.sum_ns;
+        return *this;
+    }
+};
+
+// 可以被多个线程同时记录的版本。读取得到的快照各字段之间不是原子的一致视图，
+// 记录正在进行时 count 和各桶之和可能差几个。
+class latency_histogram {
+public:
+    static constexpr std::size_t bucket_count = histogram_snapshot::bucket_count;
+
+    void record(std::chrono::nanoseconds duration) noexcept {
+        auto ns = static_cast<std::uint64_t>(std::max<std::int64_t>(0, duration.count()));
+        std::size_t i = std::min<std::size_t>(std::bit_width(ns), bucket_count - 1);
+        buckets_[i].fetch_add(1, std::memory_order_relaxed);
+        sum_ns_.fetch_add(ns, std::memory_order_relaxed);
+    }
+
+    // 只有一个线程记录时用它：普通的读和写代替原子加法（x86 上省掉 lock 前缀），读者照样可以并发读取
+    void record_single_writer(std::chrono::nanoseconds duration) noexcept {
+        auto ns = static_cast<std::uint64_t>(std::max<std::int64_t>(0, duration.count()));
+        auto& bucket = buckets_[std::min<std::size_t>(std::bit_width(ns), bucket_count - 1)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        sum_ns_.store(sum_ns_.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+    }
+
+    histogram_snapshot snapshot() const noexcept {
+        histogram_snapshot s;
+        for (std::size_t i = 0; i < bucket_count; ++i) {
+            s.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+            s.count += s.buckets[i];
+        }
+        s.sum_ns = sum_ns_.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    // 所有桶的总和，即记录过的次数
+    std::uint64_t count() const noexcept {
+        std::uint64_t n = 0;
+        for (const auto& bucket : buckets_)
+            n += bucket.load(std::memory_order_relaxed);
+        return n;
+    }
+
+    std::chrono::nanoseconds sum() const noexcept {
+        return std::chrono::nanoseconds{ static_cast<std::int64_t>(sum_ns_.load(std::memory_order_relaxed)) };
+    }
+
+private:
+    std::array<std::atomic<std::uint64_t>, bucket_count> buckets_{};
+    std::atomic<std::uint64_t>                           sum_ns_{ 0 };
+};
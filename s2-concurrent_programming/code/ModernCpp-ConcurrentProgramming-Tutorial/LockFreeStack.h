@@ -0,0 +1,310 @@
+#pragma once
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+#include "EpochReclamation.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+// 无锁栈（Treiber 栈）和无锁空闲链表，用来搭建多线程共享、不加互斥量的对象池。
+//
+// 只用 std::atomic<Node*> 做 pop 有 ABA 问题：线程 1 读到栈顶 A 和 A->next == B，准备把栈顶换成 B；
+// 这时线程 2 弹出 A、弹出 B、再把 A 压回去，栈顶又是 A，线程 1 的 CAS 照样成功，栈顶却变成了已经弹出的 B。
+// 节点被回收再利用（空闲链表正是这样）时这种事很容易发生。
+// 解决办法是给栈顶指针配一个版本号，每次修改加一，CAS 同时比较指针和版本号：
+//   - x86-64 上用 16 字节的 CAS（cmpxchg16b）同时交换指针和 64 位版本号。GCC/Clang 要加 -mcx16 才会生成这条指令；
+//   - 其它 64 位平台把 16 位版本号塞进指针的高 16 位（用户态地址只用低 48 位），用普通的 8 字节 CAS，
+//     版本号 65536 次修改绕一圈，一个线程恰好在 pop 中间停了这么久才可能出错；
+//   - 32 位平台把指针和 32 位版本号合成一个 8 字节的 CAS。
+//
+// 版本号只解决 ABA，pop 时读 head->next 还要求节点的内存没有被还给系统：
+//   - tagged_stack / lock_free_free_list 的节点只在容器析构时释放，一直可以安全地读；
+//   - treiber_stack 可以选：节点进自己的空闲链表重复使用（stack_reclaim::free_list，内存只增不减），
+//     或者交给纪元域回收（stack_reclaim::epoch，内存可以还给系统，pop 要进入一次纪元临界区）。
+
+namespace detail {
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__) && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_16)
+inline constexpr bool double_width_cas = true;
+#elif defined(_MSC_VER) && defined(_M_X64)
+inline constexpr bool double_width_cas = true;
+#else
+inline constexpr bool double_width_cas = false;
+#endif
+
+template<typename Node>
+struct tagged_ptr {
+    Node*         ptr = nullptr;
+    std::uint64_t tag = 0;
+};
+
+// 带版本号的原子指针，按平台选择实现
+template<typename Node, bool DoubleWidth = double_width_cas>
+class atomic_tagged_ptr;
+
+// 指针和版本号各占 8 字节，16 字节 CAS
+template<typename Node>
+class atomic_tagged_ptr<Node, true> {
+public:
+    // 两半分开读，可能读到不配对的指针和版本号，那样的话之后的 CAS 一定失败
+    tagged_ptr<Node> load() const noexcept {
+        std::uint64_t tag = words_[1].load(std::memory_order_acquire);
+        std::uint64_t ptr = words_[0].load(std::memory_order_acquire);
+        return { reinterpret_cast<Node*>(ptr), tag };
+    }
+
+    // 失败时把当前值写回 expected。是完整的内存屏障
+    bool compare_exchange(tagged_ptr<Node>& expected, tagged_ptr<Node> desired) noexcept {
+        auto lo = reinterpret_cast<std::uint64_t>(expected.ptr);
+#if defined(_MSC_VER)
+        alignas(16) long long comparand[2]{ static_cast<long long>(lo), static_cast<long long>(expected.tag) };
+        bool ok = _InterlockedCompareExchange128(reinterpret_cast<volatile long long*>(words_),
+            static_cast<long long>(desired.tag), reinterpret_cast<long long>(desired.ptr), comparand) != 0;
+        expected = { reinterpret_cast<Node*>(comparand[0]), static_cast<std::uint64_t>(comparand[1]) };
+        return ok;
+#else
+        using u128 = unsigned __int128;
+        u128 old_value = static_cast<u128>(expected.tag) << 64 | lo;
+        u128 new_value = static_cast<u128>(desired.tag) << 64 | reinterpret_cast<std::uint64_t>(desired.ptr);
+        u128 prev = __sync_val_compare_and_swap(reinterpret_cast<u128*>(words_), old_value, new_value);
+        if (prev == old_value)
+            return true;
+        expected = { reinterpret_cast<Node*>(static_cast<std::uint64_t>(prev)), static_cast<std::uint64_t>(prev >> 64) };
+        return false;
+#endif
+    }
+
+private:
+    alignas(16) std::atomic<std::uint64_t> words_[2]{}; // 指针，版本号
+};
+
+// 指针和版本号合成一个 8 字节整数
+template<typename Node>
+class atomic_tagged_ptr<Node, false> {
+public:
+    tagged_ptr<Node> load() const noexcept {
+        return unpack(word_.load(std::memory_order_acquire));
+    }
+
+    bool compare_exchange(tagged_ptr<Node>& expected, tagged_ptr<Node> desired) noexcept {
+        std::uint64_t old_value = pack(expected);
+        bool ok = word_.compare_exchange_weak(old_value, pack(desired), std::memory_order_acq_rel, std::memory_order_acquire);
+        if (!ok)
+            expected = unpack(old_value);
+        return ok;
+    }
+
+private:
+    static constexpr unsigned tag_shift = sizeof(void*) == 8 ? 48 : 32;
+    static constexpr std::uint64_t ptr_mask = (std::uint64_t{ 1 } << tag_shift) - 1;
+
+    static std::uint64_t pack(tagged_ptr<Node> p) noexcept {
+        return static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(p.ptr)) | p.tag << tag_shift;
+    }
+    static tagged_ptr<Node> unpack(std::uint64_t v) noexcept {
+        return { reinterpret_cast<Node*>(static_cast<std::uintptr_t>(v & ptr_mask)), v >> tag_shift };
+    }
+
+    std::atomic<std::uint64_t> word_{ 0 };
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+};
+
+} // namespace detail
+
+// 侵入式的无锁栈，Node 要有成员 std::atomic<Node*> next。
+// 不管理节点的内存：节点弹出后可以马上重新压入（版本号防止 ABA），但在栈还有人用时不能 delete，
+// 因为别的线程的 pop 可能还在读它的 next
+template<typename Node>
+class tagged_stack {
+public:
+    tagged_stack() noexcept = default;
+    tagged_stack(const tagged_stack&) = delete;
+    tagged_stack& operator=(const tagged_stack&) = delete;
+
+    void push(Node* node) noexcept {
+        auto head = head_.load();
+        do {
+            node->next.store(head.ptr, std::memory_order_relaxed);
+        } while (!head_.compare_exchange(head, { node, head.tag + 1 }));
+    }
+
+    // 栈空时返回 nullptr
+    Node* pop() noexcept {
+        auto head = head_.load();
+        while (head.ptr) {
+            // head.ptr 可能已经被别的线程弹出甚至重新压入，读到的 next 是旧的也没关系，版本号会让 CAS 失败
+            Node* next = head.ptr->next.load(std::memory_order_relaxed);
+            if (head_.compare_exchange(head, { next, head.tag + 1 }))
+                return head.ptr;
+        }
+        return nullptr;
+    }
+
+    bool empty() const noexcept {
+        return head_.load().ptr == nullptr;
+    }
+
+private:
+    detail::atomic_tagged_ptr<Node> head_;
+};
+
+// 无锁的定长内存块空闲链表，每块正好放一个 T。归还的块留着给下一次 allocate，
+// 只在链表析构时还给系统；析构时还没归还的块由使用者负责（不会被释放）。
+//
+//     lock_free_free_list<connection> pool;
+//     connection* c = pool.create(fd);    // 优先复用归还过的块
+//     pool.destroy(c);                    // 析构并归还，任何线程都可以
+template<typename T>
+class lock_free_free_list {
+public:
+    lock_free_free_list() = default;
+    explicit lock_free_free_list(std::size_t reserve_count) {
+        reserve(reserve_count);
+    }
+    ~lock_free_free_list() {
+        while (block* b = free_.pop())
+            delete b;
+    }
+
+    lock_free_free_list(const lock_free_free_list&) = delete;
+    lock_free_free_list& operator=(const lock_free_free_list&) = delete;
+
+    // 预先分配 count 块，之后的 allocate 不再调用 new
+    void reserve(std::size_t count) {
+        for (std::size_t i = 0; i < count; ++i)
+            free_.push(new block);
+    }
+
+    // 未初始化的内存，大小和对齐满足 T
+    void* allocate() {
+        if (block* b = free_.pop())
+            return b->storage;
+        return (new block)->storage;
+    }
+
+    void deallocate(void* p) noexcept {
+        free_.push(reinterpret_cast<block*>(p)); // storage 是第一个成员，地址相同
+    }
+
+    template<typename... Args>
+    T* create(Args&&... args) {
+        void* p = allocate();
+        try {
+            return ::new (p) T(std::forward<Args>(args)...);
+        }
+        catch (...) {
+            deallocate(p);
+            throw;
+        }
+    }
+
+    void destroy(T* p) noexcept {
+        p->~T();
+        deallocate(p);
+    }
+
+private:
+    // 链接用的 next 在 T 的存储之外，块在用户手里时别的线程读到的 next 也不会和 T 的构造冲突
+    struct block {
+        alignas(T) std::byte storage[sizeof(T)];
+        std::atomic<block*>  next{ nullptr };
+    };
+
+    tagged_stack<block> free_;
+};
+
+enum class stack_reclaim {
+    free_list, // 弹出的节点进空闲链表重复使用，内存只在栈析构时释放
+    epoch,     // 弹出的节点交给纪元域，确认没有线程在读之后 delete
+};
+
+// 无锁的值栈。push/pop 都是一次 CAS（竞争时重试），任何线程都可以调用。
+template<typename T, stack_reclaim Reclaim = stack_reclaim::free_list>
+class treiber_stack {
+public:
+    explicit treiber_stack(epoch_domain& domain = epoch_domain::global()) : domain_{ domain } {}
+
+    // 调用时不能还有线程在用
+    ~treiber_stack() {
+        while (node* n = head_.pop()) {
+            n->value().~T();
+            delete n;
+        }
+        while (node* n = free_.pop())
+            delete n;
+    }
+
+    treiber_stack(const treiber_stack&) = delete;
+    treiber_stack& operator=(const treiber_stack&) = delete;
+
+    void push(const T& value) {
+        emplace(value);
+    }
+    void push(T&& value) {
+        emplace(std::move(value));
+    }
+
+    template<typename... Args>
+    void emplace(Args&&... args) {
+        node* n = nullptr;
+        if constexpr (Reclaim == stack_reclaim::free_list)
+            n = free_.pop();
+        if (!n)
+            n = new node;
+        try {
+            ::new (n->storage) T(std::forward<Args>(args)...);
+        }
+        catch (...) {
+            release(n);
+            throw;
+        }
+        head_.push(n);
+    }
+
+    std::optional<T> pop() {
+        std::optional<epoch_guard> guard;
+        if constexpr (Reclaim == stack_reclaim::epoch)
+            guard.emplace(domain_);
+        node* n = head_.pop();
+        if (!n)
+            return std::nullopt;
+        std::optional<T> result{ std::move(n->value()) };
+        n->value().~T();
+        release(n);
+        return result;
+    }
+
+    bool empty() const noexcept {
+        return head_.empty();
+    }
+
+private:
+    // 值的存储和 next 分开：free_list 模式下节点被重复使用时只构造/析构值，
+    // 别的线程过时的 pop 读 next 不会和值的构造冲突
+    struct node {
+        std::atomic<node*>   next{ nullptr };
+        alignas(T) std::byte storage[sizeof(T)];
+
+        T& value() noexcept {
+            return *std::launder(reinterpret_cast<T*>(storage));
+        }
+    };
+
+    void release(node* n) {
+        if constexpr (Reclaim == stack_reclaim::free_list)
+            free_.push(n);
+        else
+            domain_.retire(n);
+    }
+
+    tagged_stack<node> head_;
+    tagged_stack<node> free_; // 只有 free_list 模式使用
+    epoch_domain&      domain_;
+};
@@ -3,6 +3,7 @@
 #include <spdlog/spdlog.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/sinks/basic_file_sink.h>
+#include "AsyncLog.h"
 
 inline void setupLogging() {
     auto file_sink = std::make_shared<spdlog::sinks::basic_file_sink_mt>("logs.txt");
@@ -20,10 +21,20 @@ inline void setupLogging() {
 }
 
 // spdlog 要想输出文件、路径、函数、行号，只能借助此宏，才会显示。
-// 其实使用 C++20 std::source_location 也能获取这些信息，后面再考虑单独封装吧，目前这样做导致没办法做格式字符串。
-
-#define LOG_INFO(msg, ...) SPDLOG_LOGGER_INFO(spdlog::get("multi_sink"), msg)
-#define LOG_WARN(msg, ...) SPDLOG_LOGGER_WARN(spdlog::get("multi_sink"), msg)
-#define LOG_ERROR(msg, ...) SPDLOG_LOGGER_ERROR(spdlog::get("multi_sink"), msg)
+// 格式字符串之后的参数原样转发给 spdlog：LOG_INFO("线程 {} 完成 {} 个任务", id, n)。
+// 默认 logger 在 setupLogging 里设置为 multi_sink，直接取裸指针，不用每次在注册表里加锁查找。
+//
+// 定义了 LOG_ASYNC 时改用 AsyncLog.h 的异步后端：调用线程只复制参数，格式化和 I/O 在后台线程里做，
+// 输出的格式和 sink 不变。
+
+#if defined(LOG_ASYNC)
+#define LOG_INFO(...)  ASYNC_LOG_INFO(__VA_ARGS__)
+#define LOG_WARN(...)  ASYNC_LOG_WARN(__VA_ARGS__)
+#define LOG_ERROR(...) ASYNC_LOG_ERROR(__VA_ARGS__)
+#else
+#define LOG_INFO(...)  SPDLOG_LOGGER_INFO(spdlog::default_logger_raw(), __VA_ARGS__)
+#define LOG_WARN(...)  SPDLOG_LOGGER_WARN(spdlog::default_logger_raw(), __VA_ARGS__)
+#define LOG_ERROR(...) SPDLOG_LOGGER_ERROR(spdlog::default_logger_raw(), __VA_ARGS__)
+#endif
 
 const auto init_log = (setupLogging(), 0);
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <new>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+// 有界无锁多生产者多消费者队列（Dmitry Vyukov 的序号环形缓冲区）。
+// 每个槽位带一个序号：等于 pos 表示第 pos 次写入可以使用它，等于 pos + 1 表示数据已写好、
+// 可以被第 pos 次读取取走，读完后变成 pos + capacity 留给下一圈的写入。
+// 生产者和消费者只在各自的下标（tail_ / head_）上竞争，彼此之间只通过槽位的序号同步。
+//
+// try_push / try_pop 不阻塞；push / pop 先用 fetch_add 领取一个位置，再在该槽位的序号上
+// atomic::wait，直到轮到自己。两类接口可以混用。
+template<typename T>
+class mpmc_queue {
+    static_assert(std::is_nothrow_move_constructible_v<T> && std::is_nothrow_destructible_v<T>);
+
+    // 每个槽位独占缓存行，相邻位置的读写不会互相干扰
+    struct alignas(64) slot {
+        std::atomic<std::size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* value() noexcept { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+public:
+    // 容量向上取整为 2 的幂（至少为 2）
+    explicit mpmc_queue(std::size_t capacity) :
+        capacity_{ std::bit_ceil(capacity < 2 ? std::size_t{ 2 } : capacity) },
+        slots_{ new slot[capacity_] }
+    {
+        for (std::size_t i = 0; i < capacity_; ++i)
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    mpmc_queue(const mpmc_queue&) = delete;
+    mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+    // 析构时不能再有其它线程访问队列
+    ~mpmc_queue() {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        for (std::size_t pos = head; static_cast<std::ptrdiff_t>(tail - pos) > 0; ++pos) {
+            slot& s = slots_[pos & (capacity_ - 1)];
+            if (s.sequence.load(std::memory_order_relaxed) == pos + 1)
+                s.value()->~T();
+        }
+        delete[] slots_;
+    }
+
+    template<typename ...Args>
+    bool try_emplace(Args&&... args) {
+        std::size_t pos = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            slot& s = slots_[pos & (capacity_ - 1)];
+            std::size_t seq = s.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq - pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    construct(s, pos, std::forward<Args>(args)...);
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                return false; // 满：这个槽位上一圈的数据还没被取走
+            }
+            else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+    bool try_push(const T& value) { return try_emplace(value); }
+    bool try_push(T&& value) { return try_emplace(std::move(value)); }
+
+    bool try_pop(T& value) {
+        std::size_t pos = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            slot& s = slots_[pos & (capacity_ - 1)];
+            std::size_t seq = s.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq - (pos + 1));
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = take(s, pos);
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                return false; // 空
+            }
+            else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+    std::optional<T> try_pop() {
+        std::optional<T> result;
+        std::size_t pos = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            slot& s = slots_[pos & (capacity_ - 1)];
+            std::size_t seq = s.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq - (pos + 1));
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    result.emplace(take(s, pos));
+                    return result;
+                }
+            }
+            else if (diff < 0) {
+                return result;
+            }
+            else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // 阻塞直到有空位
+    template<typename ...Args>
+    void emplace(Args&&... args) {
+        std::size_t pos = tail_.fetch_add(1, std::memory_order_relaxed);
+        slot& s = slots_[pos & (capacity_ - 1)];
+        wait_for_turn(s, pos);
+        construct(s, pos, std::forward<Args>(args)...);
+    }
+    void push(const T& value) { emplace(value); }
+    void push(T&& value) { emplace(std::move(value)); }
+
+    // 阻塞直到有数据
+    T pop() {
+        std::size_t pos = head_.fetch_add(1, std::memory_order_relaxed);
+        slot& s = slots_[pos & (capacity_ - 1)];
+        wait_for_turn(s, pos + 1);
+        return take(s, pos);
+    }
+    void pop(T& value) {
+        value = pop();
+    }
+
+    std::size_t capacity() const noexcept { return capacity_; }
+
+    // 近似值；有阻塞的 pop 在等待时可能为负，按 0 处理
+    std::size_t size_approx() const noexcept {
+        auto diff = static_cast<std::ptrdiff_t>(tail_.load(std::memory_order_relaxed) - head_.load(std::memory_order_relaxed));
+        return diff < 0 ? 0 : static_cast<std::size_t>(diff);
+    }
+    bool empty() const noexcept { return size_approx() == 0; }
+
+private:
+    // 先自旋，再让出时间片（对方可能和我们共用一个核），最后才在序号上睡眠；序号只会单调增加
+    static void wait_for_turn(slot& s, std::size_t expected) noexcept {
+        for (int spin = 0; spin < 64; ++spin) {
+            if (s.sequence.load(std::memory_order_acquire) == expected)
+                return;
+        }
+        for (int yield = 0; yield < 16; ++yield) {
+            std::this_thread::yield();
+            if (s.sequence.load(std::memory_order_acquire) == expected)
+                return;
+        }
+        for (std::size_t seq = s.sequence.load(std::memory_order_acquire); seq != expected;
+             seq = s.sequence.load(std::memory_order_acquire))
+            s.sequence.wait(seq, std::memory_order_acquire);
+    }
+
+    // 槽位领取后无法退还（下一圈的读写在等这个序号），所以构造抛出异常会直接 std::terminate
+    template<typename ...Args>
+    void construct(slot& s, std::size_t pos, Args&&... args) noexcept {
+        ::new (static_cast<void*>(s.storage)) T(std::forward<Args>(args)...);
+        s.sequence.store(pos + 1, std::memory_order_release);
+        s.sequence.notify_all();
+    }
+
+    T take(slot& s, std::size_t pos) noexcept {
+        T* ptr = s.value();
+        T value{ std::move(*ptr) };
+        ptr->~T();
+        s.sequence.store(pos + capacity_, std::memory_order_release);
+        s.sequence.notify_all();
+        return value;
+    }
+
+    const std::size_t capacity_;
+    slot* const       slots_;
+
+    alignas(64) std::atomic<std::size_t> head_{ 0 };
+    alignas(64) std::atomic<std::size_t> tail_{ 0 };
+};
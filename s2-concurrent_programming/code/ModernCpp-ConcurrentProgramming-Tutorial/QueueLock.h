@@ -0,0 +1,170 @@
+#pragma once
+
+#include "CpuRelax.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// 公平的排队锁：按到达顺序获得锁，不会有线程一直抢不到。都满足 Lockable，可以配合
+// std::lock_guard/std::unique_lock 使用。
+// 严格 FIFO 的代价是线程多于核数时，排在下一个的线程如果没在运行，锁就只能空着等它被调度，
+// 所以等待一段时间后改为每轮让出时间片；这种场合还是 adaptive_mutex 或 std::mutex 更合适。
+
+namespace detail {
+
+// 排队锁的等待策略：先 pause 自旋，等太久就开始让出时间片
+class queue_lock_waiter {
+public:
+    void pause(std::uint32_t rounds = 1) noexcept {
+        if (spins_ < yield_after) {
+            spins_ += rounds;
+            for (std::uint32_t i = 0; i < rounds; ++i)
+                cpu_relax();
+        }
+        else {
+            std::this_thread::yield();
+        }
+    }
+
+private:
+    static constexpr std::uint32_t yield_after = 4096; // 次 pause
+
+    std::uint32_t spins_ = 0;
+};
+
+} // namespace detail
+
+// 票号锁：取一个号，等叫到自己的号。只有两个计数器，加锁是一次 fetch_add，解锁是一次 store。
+// 所有等待者都读同一个 serving_，每次解锁这条缓存行要传给每个等待者，等待者越多越慢；
+// 按前面还有几个人成比例地退避，减轻这个问题。
+class ticket_mutex {
+public:
+    ticket_mutex() noexcept = default;
+    ticket_mutex(const ticket_mutex&) = delete;
+    ticket_mutex& operator=(const ticket_mutex&) = delete;
+
+    void lock() noexcept {
+        std::uint32_t ticket = next_.fetch_add(1, std::memory_order_relaxed);
+        detail::queue_lock_waiter waiter;
+        for (;;) {
+            std::uint32_t serving = serving_.load(std::memory_order_acquire);
+            if (serving == ticket)
+                return;
+            waiter.pause((ticket - serving) * backoff_per_waiter);
+        }
+    }
+
+    // 只在锁空闲、也没有人排队时成功。和上一个持有者同步靠的是读 serving_ 的 acquire，
+    // next_ 上的 CAS 只负责取号
+    bool try_lock() noexcept {
+        std::uint32_t serving = serving_.load(std::memory_order_acquire);
+        std::uint32_t expected = serving;
+        return next_.compare_exchange_strong(expected, serving + 1, std::memory_order_relaxed, std::memory_order_relaxed);
+    }
+
+    void unlock() noexcept {
+        serving_.store(serving_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+private:
+    static constexpr std::uint32_t backoff_per_waiter = 8; // 次 pause
+
+    alignas(64) std::atomic<std::uint32_t> next_{ 0 };    // 下一个要发出的号
+    alignas(64) std::atomic<std::uint32_t> serving_{ 0 }; // 正在服务的号，只有持有者写
+};
+
+// MCS 队列锁：每个等待者在自己的节点上自旋，前一个持有者解锁时只写下一个等待者的节点，
+// 解锁的开销和等待者的数量无关。节点取自线程局部的节点池（嵌套持有几把锁就用几个节点），
+// 持有者把节点记在锁里，所以接口和普通的互斥量一样，不需要调用者传入节点。
+class mcs_mutex {
+public:
+    mcs_mutex() noexcept = default;
+    mcs_mutex(const mcs_mutex&) = delete;
+    mcs_mutex& operator=(const mcs_mutex&) = delete;
+
+    void lock() {
+        node* self = acquire_node();
+        node* prev = tail_.exchange(self, std::memory_order_acq_rel);
+        if (prev != nullptr) {
+            prev->next.store(self, std::memory_order_release);
+            detail::queue_lock_waiter waiter;
+            while (self->locked.load(std::memory_order_acquire))
+                waiter.pause();
+        }
+        holder_ = self;
+    }
+
+    bool try_lock() {
+        if (tail_.load(std::memory_order_relaxed) != nullptr)
+            return false;
+        node* self = acquire_node();
+        node* expected = nullptr;
+        if (!tail_.compare_exchange_strong(expected, self, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+            release_node(self);
+            return false;
+        }
+        holder_ = self;
+        return true;
+    }
+
+    void unlock() noexcept {
+        node* self = holder_;
+        node* next = self->next.load(std::memory_order_acquire);
+        if (next == nullptr) {
+            node* expected = self;
+            if (tail_.compare_exchange_strong(expected, nullptr, std::memory_order_release, std::memory_order_relaxed)) {
+                release_node(self);
+                return;
+            }
+            // 有新的等待者已经排到了后面，但还没来得及把自己挂到 next 上
+            detail::queue_lock_waiter waiter;
+            while ((next = self->next.load(std::memory_order_acquire)) == nullptr)
+                waiter.pause();
+        }
+        next->locked.store(false, std::memory_order_release);
+        release_node(self); // 交接完成后不会再有线程访问这个节点
+    }
+
+private:
+    struct alignas(64) node {
+        std::atomic<node*> next{ nullptr };
+        std::atomic<bool>  locked{ true };
+    };
+
+    struct node_pool {
+        std::vector<std::unique_ptr<node>> free;
+        std::size_t                        created = 0;
+    };
+    static node_pool& pool() noexcept {
+        thread_local node_pool instance;
+        return instance;
+    }
+
+    static node* acquire_node() {
+        node_pool& p = pool();
+        node* n;
+        if (p.free.empty()) {
+            p.free.reserve(p.created + 1); // 所有节点都能放回来，release_node 不会再分配
+            n = new node;
+            ++p.created;
+        }
+        else {
+            n = p.free.back().release();
+            p.free.pop_back();
+        }
+        n->next.store(nullptr, std::memory_order_relaxed);
+        n->locked.store(true, std::memory_order_relaxed);
+        return n;
+    }
+
+    // 节点由持有者在解锁时归还，所以总是回到取出它的线程
+    static void release_node(node* n) noexcept {
+        pool().free.emplace_back(n);
+    }
+
+    alignas(64) std::atomic<node*> tail_{ nullptr };
+    node*                          holder_ = nullptr; // 当前持有者的节点，只有持有者读写
+};
@@ -0,0 +1,222 @@
+#pragma once
+
+#include "CpuRelax.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+// 单生产者单消费者环形缓冲区，push 和 pop 都是无等待的（没有循环重试）。
+// 生产者只写 tail_，消费者只写 head_；双方各自缓存对方的下标，只有缓存的值显示满/空时
+// 才去读对方的缓存行，稳态下每次操作只碰自己的缓存行和数据槽。
+// 批量接口一次搬运多个元素，只发布一次下标。
+//
+// 阻塞接口的等待方式由构造参数决定：
+//   spin  : 忙等（pause），延迟最低，但要求两端各占一个核
+//   block : 短暂自旋和让出后在对方的下标上 atomic::wait，对方发布时 notify
+enum class spsc_wait {
+    spin,
+    block
+};
+
+template<typename T>
+class spsc_queue {
+    static_assert(std::is_nothrow_move_constructible_v<T> && std::is_nothrow_destructible_v<T>);
+
+public:
+    // 容量向上取整为 2 的幂
+    explicit spsc_queue(std::size_t capacity, spsc_wait wait = spsc_wait::spin) :
+        capacity_{ std::bit_ceil(std::max<std::size_t>(capacity, 1)) },
+        wait_{ wait },
+        buffer_{ std::allocator<T>{}.allocate(capacity_) }
+    {}
+    spsc_queue(const spsc_queue&) = delete;
+    spsc_queue& operator=(const spsc_queue&) = delete;
+
+    ~spsc_queue() {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        for (std::size_t pos = head_.load(std::memory_order_relaxed); pos != tail; ++pos)
+            std::destroy_at(slot(pos));
+        std::allocator<T>{}.deallocate(buffer_, capacity_);
+    }
+
+    // ---------------- 生产者 ----------------
+
+    template<typename ...Args>
+    bool try_emplace(Args&&... args) {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (free_space(tail) == 0)
+            return false;
+        std::construct_at(slot(tail), std::forward<Args>(args)...);
+        publish_tail(tail + 1);
+        return true;
+    }
+    bool try_push(const T& value) { return try_emplace(value); }
+    bool try_push(T&& value) { return try_emplace(std::move(value)); }
+
+    // 尽量多地拷贝，返回实际写入的个数
+    std::size_t try_push(std::span<const T> values) {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        std::size_t count = std::min(values.size(), free_space(tail));
+        if (count == 0)
+            return 0;
+        for (std::size_t i = 0; i < count; ++i)
+            std::construct_at(slot(tail + i), values[i]);
+        publish_tail(tail + count);
+        return count;
+    }
+
+    template<typename ...Args>
+    void emplace(Args&&... args) {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        while (free_space(tail) == 0)
+            wait_for_change(head_, cached_head_);
+        std::construct_at(slot(tail), std::forward<Args>(args)...);
+        publish_tail(tail + 1);
+    }
+    void push(const T& value) { emplace(value); }
+    void push(T&& value) { emplace(std::move(value)); }
+
+    // 阻塞直到全部写入
+    void push(std::span<const T> values) {
+        while (!values.empty()) {
+            std::size_t count = try_push(values);
+            if (count == 0)
+                wait_for_change(head_, cached_head_);
+            values = values.subspan(count);
+        }
+    }
+
+    // ---------------- 消费者 ----------------
+
+    bool try_pop(T& value) {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        if (available(head) == 0)
+            return false;
+        value = take(head);
+        publish_head(head + 1);
+        return true;
+    }
+
+    // 尽量多地取出（移动赋值到 out），返回实际取出的个数
+    std::size_t try_pop(std::span<T> out) {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        std::size_t count = std::min(out.size(), available(head));
+        if (count == 0)
+            return 0;
+        for (std::size_t i = 0; i < count; ++i)
+            out[i] = take(head + i);
+        publish_head(head + count);
+        return count;
+    }
+
+    T pop() {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        while (available(head) == 0)
+            wait_for_change(tail_, cached_tail_);
+        T value = take(head);
+        publish_head(head + 1);
+        return value;
+    }
+    void pop(T& value) {
+        value = pop();
+    }
+
+    // 阻塞直到至少取出一个（out 为空时直接返回 0）
+    std::size_t pop(std::span<T> out) {
+        if (out.empty())
+            return 0;
+        std::size_t count;
+        while ((count = try_pop(out)) == 0)
+            wait_for_change(tail_, cached_tail_);
+        return count;
+    }
+
+    // ---------------- 任意线程（近似值） ----------------
+
+    std::size_t capacity() const noexcept { return capacity_; }
+    std::size_t size_approx() const noexcept {
+        return tail_.load(std::memory_order_relaxed) - head_.load(std::memory_order_relaxed);
+    }
+    bool empty() const noexcept { return size_approx() == 0; }
+
+private:
+    T* slot(std::size_t pos) const noexcept {
+        return buffer_ + (pos & (capacity_ - 1));
+    }
+
+    // 生产者调用：先看缓存的 head，不够时才读一次真正的 head_
+    std::size_t free_space(std::size_t tail) noexcept {
+        std::size_t space = capacity_ - (tail - cached_head_);
+        if (space == 0) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            space = capacity_ - (tail - cached_head_);
+        }
+        return space;
+    }
+
+    // 消费者调用
+    std::size_t available(std::size_t head) noexcept {
+        std::size_t count = cached_tail_ - head;
+        if (count == 0) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            count = cached_tail_ - head;
+        }
+        return count;
+    }
+
+    T take(std::size_t pos) noexcept {
+        T* ptr = slot(pos);
+        T value{ std::move(*ptr) };
+        std::destroy_at(ptr);
+        return value;
+    }
+
+    void publish_tail(std::size_t tail) noexcept {
+        tail_.store(tail, std::memory_order_release);
+        if (wait_ == spsc_wait::block)
+            tail_.notify_one();
+    }
+    void publish_head(std::size_t head) noexcept {
+        head_.store(head, std::memory_order_release);
+        if (wait_ == spsc_wait::block)
+            head_.notify_one();
+    }
+
+    // 等对方的下标离开 cached（调用者随后重新检查）
+    void wait_for_change(const std::atomic<std::size_t>& index, std::size_t cached) const noexcept {
+        for (int spin = 0; spin < 256; ++spin) {
+            if (index.load(std::memory_order_acquire) != cached)
+                return;
+            cpu_relax();
+        }
+        if (wait_ == spsc_wait::spin) {
+            std::this_thread::yield(); // 偶尔让一下，防止和对方抢同一个核时活锁
+            return;
+        }
+        // 对方可能和我们共用一个核，先让出时间片给它攒一批数据，再真正睡眠
+        for (int yield = 0; yield < 16; ++yield) {
+            std::this_thread::yield();
+            if (index.load(std::memory_order_acquire) != cached)
+                return;
+        }
+        index.wait(cached, std::memory_order_acquire);
+    }
+
+    const std::size_t capacity_;
+    const spsc_wait   wait_;
+    T* const          buffer_;
+
+    // 生产者的缓存行：自己的下标和对 head_ 的缓存
+    alignas(64) std::atomic<std::size_t> tail_{ 0 };
+    std::size_t                          cached_head_ = 0;
+
+    // 消费者的缓存行
+    alignas(64) std::atomic<std::size_t> head_{ 0 };
+    std::size_t                          cached_tail_ = 0; // 类按 64 对齐，后面不会紧挨别的数据
+};
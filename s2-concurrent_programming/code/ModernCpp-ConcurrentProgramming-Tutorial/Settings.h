@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+
+// 读多写少的配置表，读者不加锁（RCU 风格的写时复制）。
+// 每次修改都复制整张表、改好后整体发布一个新的不可变快照；读者读的永远是某个完整的快照，
+// 旧快照在最后一个读者放手后由 shared_ptr 释放。
+//
+// shared_mutex 的读锁每次都要对锁字做一次原子读-改-写，读者一多这条缓存行就在各个核之间来回传递；
+// atomic<shared_ptr>::load 同样要修改引用计数（libstdc++ 还要加一次内部的自旋锁）。
+// 所以读取走 reader：每个读线程持有一个，里面缓存着快照，平时只做一次 acquire 读取比较版本号，
+// 版本变了才重新取快照。读路径上没有任何读-改-写，返回的 string_view 指向快照内部，不复制字符串。
+//
+//     rcu_settings settings;
+//     settings.set("1", "a");
+//     auto reader = settings.make_reader();   // 每个读线程一个
+//     std::string_view v = reader.get("1");    // 在这个 reader 下一次刷新快照之前有效
+
+class settings_snapshot {
+public:
+    using map_type = std::map<std::string, std::string, std::less<>>; // 透明比较，可以直接用 string_view 查找
+
+    settings_snapshot() = default;
+    settings_snapshot(map_type data, std::uint64_t version) : data_{ std::move(data) }, version_{ version } {}
+
+    // 没有这个键时返回空字符串
+    std::string_view get(std::string_view key) const noexcept {
+        auto it = data_.find(key);
+        return it != data_.end() ? std::string_view{ it->second } : std::string_view{};
+    }
+    bool contains(std::string_view key) const noexcept {
+        return data_.find(key) != data_.end();
+    }
+
+    const map_type& data() const noexcept { return data_; }
+    std::uint64_t version() const noexcept { return version_; }
+
+private:
+    map_type      data_;
+    std::uint64_t version_ = 0;
+};
+
+class rcu_settings {
+public:
+    using map_type = settings_snapshot::map_type;
+
+    rcu_settings() : current_{ std::make_shared<const settings_snapshot>() } {}
+    rcu_settings(const rcu_settings&) = delete;
+    rcu_settings& operator=(const rcu_settings&) = delete;
+
+    void set(std::string key, std::string value) {
+        update([&](map_type& data) { data.insert_or_assign(std::move(key), std::move(value)); });
+    }
+    void erase(std::string_view key) {
+        update([&](map_type& data) {
+            if (auto it = data.find(key); it != data.end())
+                data.erase(it);
+        });
+    }
+
+    // 在一份副本上做任意多处修改，一次发布。写者之间用互斥量串行，每次修改复制整张表，
+    // 适合几百项以内、很少修改的配置
+    template<typename F>
+    void update(F&& modify) {
+        std::lock_guard<std::mutex> lc{ write_mutex_ };
+        map_type data = current_.load(std::memory_order_relaxed)->data();
+        std::invoke(std::forward<F>(modify), data);
+        std::uint64_t version = version_.load(std::memory_order_relaxed) + 1;
+        current_.store(std::make_shared<const settings_snapshot>(std::move(data), version), std::memory_order_release);
+        version_.store(version, std::memory_order_release); // 先发布快照再改版本号，读者看到新版本号时一定取得到新快照
+    }
+
+    // 需要长期持有某个快照（或者跨线程传递）时用它；每次调用都会修改引用计数
+    std::shared_ptr<const settings_snapshot> snapshot() const {
+        return current_.load(std::memory_order_acquire);
+    }
+
+    // 一个读线程专用的读取入口，不能多个线程共用
+    class reader {
+    public:
+        explicit reader(const rcu_settings& owner) : owner_{ &owner }, cached_{ owner.snapshot() } {}
+
+        // 最新的快照。引用（以及从中取得的 string_view）在这个 reader 下一次刷新之前有效，
+        // 也就是下一次调用 current/get 并且期间有过修改时失效
+        const settings_snapshot& current() {
+            if (owner_->version_.load(std::memory_order_acquire) != cached_->version())
+                cached_ = owner_->snapshot();
+            return *cached_;
+        }
+
+        std::string_view get(std::string_view key) {
+            return current().get(key);
+        }
+
+    private:
+        const rcu_settings*                      owner_;
+        std::shared_ptr<const settings_snapshot> cached_; // 读者闲着时也会留住一个旧快照
+    };
+
+    reader make_reader() const {
+        return reader{ *this };
+    }
+
+private:
+    std::atomic<std::shared_ptr<const settings_snapshot>> current_;
+    std::mutex                                            write_mutex_;
+    alignas(64) std::atomic<std::uint64_t>                version_{ 0 }; // 读者平时只读这一个字，不和写者的锁共用缓存行
+};
@@ -0,0 +1,211 @@
+#pragma once
+
+#include "CpuTopology.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+// 写多读少的统计计数器（请求数、字节数……）。
+// 全局的 std::atomic<std::uint64_t> 每次 fetch_add 都要把那条缓存行抢到自己的核上，
+// 线程一多，计数本身就成了热点；放在它旁边的其它变量也跟着伪共享。这里把计数拆开：
+//
+//   sharded_counter : 每个线程一个按缓存行对齐的槽位，只有自己写。add 是普通的读-加-写（relaxed 的 load/store，
+//                     没有 lock 前缀的读-改-写），read 把所有槽位加起来。线程退出后槽位留给新线程接着累加，
+//                     数值不会丢。槽位数等于同时用过它的线程数。
+//   per_cpu_counter : 每个 CPU 一个槽位，add 先用 sched_getcpu 查当前 CPU，再对那个槽位 fetch_add。
+//                     线程随时可能被迁走或抢占，所以仍然要原子操作，但那条缓存行一般就在本核上，没有竞争。
+//                     槽位数固定是 CPU 数，适合线程很多、来来去去的场合；不支持的平台按线程号分散。
+//
+// read 不是某一时刻的快照：加的同时在读，结果介于读开始和结束时的值之间。
+//
+//     inline sharded_counter requests;
+//     requests.add();                // 工作线程里
+//     std::uint64_t n = requests.read();
+
+class sharded_counter {
+public:
+    sharded_counter() : id_{ next_id() } {
+        std::lock_guard<std::mutex> lc{ registry_mutex() };
+        live_counters().insert(id_);
+    }
+
+    ~sharded_counter() {
+        {
+            std::lock_guard<std::mutex> lc{ registry_mutex() };
+            live_counters().erase(id_);
+        }
+        for (slot* s = slots_.load(std::memory_order_acquire); s;) {
+            slot* next = s->next;
+            delete s;
+            s = next;
+        }
+    }
+
+    sharded_counter(const sharded_counter&) = delete;
+    sharded_counter& operator=(const sharded_counter&) = delete;
+
+    void add(std::uint64_t n = 1) {
+        slot& s = local();
+        // 只有本线程写这个槽位，不需要读-改-写
+        s.value.store(s.value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    sharded_counter& operator+=(std::uint64_t n) {
+        add(n);
+        return *this;
+    }
+    sharded_counter& operator++() {
+        add(1);
+        return *this;
+    }
+
+    std::uint64_t read() const noexcept {
+        std::uint64_t sum = 0;
+        for (const slot* s = slots_.load(std::memory_order_acquire); s; s = s->next)
+            sum += s->value.load(std::memory_order_relaxed);
+        return sum;
+    }
+
+private:
+    struct alignas(64) slot {
+        std::atomic<std::uint64_t> value{ 0 };
+        std::atomic<bool>          in_use{ true };
+        slot*                      next = nullptr; // 只增不删
+    };
+
+    // 每个线程记住自己在哪些计数器里有槽位，线程退出时归还
+    struct thread_slots {
+        struct entry {
+            std::uint64_t counter_id;
+            slot*         s;
+        };
+
+        std::uint64_t      last_id = 0; // 最近用过的计数器
+        slot*              last = nullptr;
+        std::vector<entry> entries;
+
+        ~thread_slots() {
+            std::lock_guard<std::mutex> lc{ registry_mutex() };
+            for (auto& e : entries) {
+                if (live_counters().contains(e.counter_id)) // 计数器已经析构的话槽位也没了
+                    e.s->in_use.store(false, std::memory_order_release);
+            }
+        }
+    };
+
+    static thread_slots& registrations() {
+        thread_local thread_slots instance;
+        return instance;
+    }
+
+    slot& local() {
+        auto& r = registrations();
+        if (r.last_id == id_)
+            return *r.last;
+        return attach(r);
+    }
+
+    slot& attach(thread_slots& r) {
+        slot* found = nullptr;
+        for (auto& e : r.entries) {
+            if (e.counter_id == id_)
+                found = e.s;
+        }
+        if (!found) {
+            // 先找退出的线程留下的槽位，值接着累加
+            for (slot* s = slots_.load(std::memory_order_acquire); s && !found; s = s->next) {
+                bool expected = false;
+                if (!s->in_use.load(std::memory_order_relaxed) &&
+                    s->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire))
+                    found = s;
+            }
+            if (!found) {
+                found = new slot;
+                slot* head = slots_.load(std::memory_order_relaxed);
+                do {
+                    found->next = head;
+                } while (!slots_.compare_exchange_weak(head, found, std::memory_order_release, std::memory_order_relaxed));
+            }
+            r.entries.push_back({ id_, found });
+        }
+        r.last_id = id_;
+        r.last = found;
+        return *found;
+    }
+
+    static std::uint64_t next_id() noexcept {
+        static std::atomic<std::uint64_t> id{ 0 };
+        return id.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+    static std::mutex& registry_mutex() {
+        static std::mutex m;
+        return m;
+    }
+    static std::unordered_set<std::uint64_t>& live_counters() {
+        static std::unordered_set<std::uint64_t> ids;
+        return ids;
+    }
+
+    const std::uint64_t  id_;
+    std::atomic<slot*>   slots_{ nullptr };
+};
+
+class per_cpu_counter {
+public:
+    per_cpu_counter() : count_{ slot_count() }, slots_{ std::make_unique<slot[]>(count_) } {}
+
+    per_cpu_counter(const per_cpu_counter&) = delete;
+    per_cpu_counter& operator=(const per_cpu_counter&) = delete;
+
+    void add(std::uint64_t n = 1) noexcept {
+        slots_[index()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    per_cpu_counter& operator+=(std::uint64_t n) noexcept {
+        add(n);
+        return *this;
+    }
+    per_cpu_counter& operator++() noexcept {
+        add(1);
+        return *this;
+    }
+
+    std::uint64_t read() const noexcept {
+        std::uint64_t sum = 0;
+        for (std::size_t i = 0; i < count_; ++i)
+            sum += slots_[i].value.load(std::memory_order_relaxed);
+        return sum;
+    }
+
+private:
+    struct alignas(64) slot {
+        std::atomic<std::uint64_t> value{ 0 };
+    };
+
+    // CPU 编号可能不连续，也可能之后放开了亲和性限制，取两者较大的，用的时候再取模
+    static std::size_t slot_count() {
+        unsigned max_id = 0;
+        for (const auto& c : cpu_topology::get().cpus())
+            max_id = std::max(max_id, c.id);
+        return std::max<std::size_t>({ std::size_t{ max_id } + 1, std::thread::hardware_concurrency(), 1 });
+    }
+
+    std::size_t index() const noexcept {
+        int cpu = current_cpu();
+        if (cpu >= 0)
+            return static_cast<std::size_t>(cpu) % count_;
+        // 拿不到 CPU 编号时按线程分散，同一线程总落在同一个槽位
+        thread_local const std::size_t fallback = std::hash<std::thread::id>{}(std::this_thread::get_id());
+        return fallback % count_;
+    }
+
+    std::size_t             count_;
+    std::unique_ptr<slot[]> slots_;
+};
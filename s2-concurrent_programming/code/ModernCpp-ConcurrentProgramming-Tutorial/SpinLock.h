@@ -0,0 +1,115 @@
+#pragma once
+
+#include "CpuRelax.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+// 用 atomic_flag 实现的自旋锁，满足 Lockable，可以配合 std::lock_guard/std::unique_lock 使用。
+// 测试-测试-设置（TTAS）：锁被占用时只读地等待，读命中本线程的缓存，不会像反复 test_and_set
+// 那样让缓存行在各个核之间来回传递；每次抢锁失败后指数退避，错开同时看到锁释放的线程。
+// 等待时一直占着 CPU，只适合临界区极短、线程数不超过核数的场合，否则用 adaptive_mutex。
+class spinlock_mutex {
+public:
+    spinlock_mutex() noexcept = default;
+    spinlock_mutex(const spinlock_mutex&) = delete;
+    spinlock_mutex& operator=(const spinlock_mutex&) = delete;
+
+    void lock() noexcept {
+        for (unsigned backoff = 1; flag_.test_and_set(std::memory_order_acquire); backoff = std::min(backoff * 2, max_backoff)) {
+            for (unsigned i = 0; i < backoff; ++i)
+                cpu_relax();
+            while (flag_.test(std::memory_order_relaxed))
+                cpu_relax();
+        }
+    }
+
+    bool try_lock() noexcept {
+        return !flag_.test(std::memory_order_relaxed) && !flag_.test_and_set(std::memory_order_acquire);
+    }
+
+    void unlock() noexcept {
+        flag_.clear(std::memory_order_release);
+    }
+
+private:
+    static constexpr unsigned max_backoff = 64; // 次 pause
+
+    std::atomic_flag flag_{};
+};
+
+// 先自旋、再睡眠的互斥量，满足 Lockable。
+// 没有竞争时加锁解锁各一次原子操作，和自旋锁一样便宜；锁被占用时先按 spinlock_mutex 的方式
+// 自旋一小段（持有者多半很快释放，省掉两次系统调用），还没拿到就在 futex 上睡眠（atomic::wait），
+// 不会在线程数多于核数时空转着抢走持有者的 CPU。
+// 自旋多久是自适应的：记录最近几次自旋成功时花了多少，下次最多自旋它的两倍；
+// 自旋落空就把预算减半，临界区长的锁很快退化成直接睡眠。单核机器上不自旋。
+class adaptive_mutex {
+public:
+    adaptive_mutex() noexcept = default;
+    adaptive_mutex(const adaptive_mutex&) = delete;
+    adaptive_mutex& operator=(const adaptive_mutex&) = delete;
+
+    void lock() noexcept {
+        std::uint32_t expected = unlocked;
+        if (!state_.compare_exchange_strong(expected, locked, std::memory_order_acquire, std::memory_order_relaxed))
+            lock_slow();
+    }
+
+    bool try_lock() noexcept {
+        std::uint32_t expected = unlocked;
+        return state_.load(std::memory_order_relaxed) == unlocked &&
+               state_.compare_exchange_strong(expected, locked, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    // 只有可能有线程在睡眠（contended）时才需要唤醒，没有竞争时不进内核
+    void unlock() noexcept {
+        if (state_.exchange(unlocked, std::memory_order_release) == contended)
+            state_.notify_one();
+    }
+
+private:
+    static constexpr std::uint32_t unlocked  = 0;
+    static constexpr std::uint32_t locked    = 1; // 被持有，没有线程在睡眠
+    static constexpr std::uint32_t contended = 2; // 被持有，可能有线程在睡眠
+
+    static constexpr std::uint32_t min_spin    = 64;     // 自旋预算（pause 次数）的上下限
+    static constexpr std::uint32_t max_spin    = 16'384;
+    static constexpr unsigned      max_backoff = 64;
+
+    void lock_slow() noexcept {
+        static const bool single_cpu = std::thread::hardware_concurrency() == 1; // 持有者要等我们让出 CPU 才能释放
+        if (!single_cpu && spin())
+            return;
+        // 睡眠前把状态改成 contended：解锁者看到它才会唤醒。抢到锁时也留着 contended，
+        // 因为可能还有别的线程在睡眠，多一次不必要的唤醒好过漏掉一个。
+        while (state_.exchange(contended, std::memory_order_acquire) != unlocked)
+            state_.wait(contended, std::memory_order_relaxed);
+    }
+
+    bool spin() noexcept {
+        std::uint32_t estimate = spin_estimate_.load(std::memory_order_relaxed);
+        std::uint32_t budget = std::clamp(estimate * 2, min_spin, max_spin);
+        std::uint32_t spent = 0;
+        for (unsigned backoff = 1; spent < budget; backoff = std::min(backoff * 2, max_backoff)) {
+            std::uint32_t s = state_.load(std::memory_order_relaxed);
+            if (s == unlocked && state_.compare_exchange_weak(s, locked, std::memory_order_acquire, std::memory_order_relaxed)) {
+                // 估计值向这次实际花的时间靠拢（指数滑动平均，权重 1/8）
+                auto next = static_cast<std::int32_t>(estimate) + (static_cast<std::int32_t>(spent) - static_cast<std::int32_t>(estimate)) / 8;
+                spin_estimate_.store(static_cast<std::uint32_t>(next), std::memory_order_relaxed);
+                return true;
+            }
+            if (s == contended)
+                break; // 已经有线程在睡眠，排在它们后面，自旋只会白白抢它们的 CPU
+            for (unsigned i = 0; i < backoff; ++i)
+                cpu_relax();
+            spent += backoff;
+        }
+        spin_estimate_.store(estimate / 2, std::memory_order_relaxed);
+        return false;
+    }
+
+    std::atomic<std::uint32_t> state_{ unlocked };
+    std::atomic<std::uint32_t> spin_estimate_{ min_spin }; // 只是提示，并发更新丢失几次也无妨
+};
@@ -0,0 +1,524 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+// 只能移动的 void() 可调用对象包装。
+// 和 std::function / std::packaged_task 不同，只有超过 inline_size 的可调用对象才会在堆上分配，
+// 线程池里常见的“一个 lambda 捕获几个指针”直接放在内部缓冲区里。整个对象正好一条缓存行。
+class unique_task {
+public:
+    static constexpr std::size_t inline_size = 48;
+
+    unique_task() noexcept = default;
+
+    template<typename F>
+        requires (!std::is_same_v<std::remove_cvref_t<F>, unique_task> && std::is_invocable_v<std::decay_t<F>&>)
+    unique_task(F&& f) {
+        using Fn = std::decay_t<F>;
+        if constexpr (fits_inline<Fn>) {
+            ::new (static_cast<void*>(storage_)) Fn(std::forward<F>(f));
+            ops_ = &inline_ops<Fn>;
+        }
+        else {
+            ::new (static_cast<void*>(storage_)) Fn*(new Fn(std::forward<F>(f)));
+            ops_ = &heap_ops<Fn>;
+        }
+    }
+
+    unique_task(unique_task&& other) noexcept : ops_{ other.ops_ } {
+        if (ops_) {
+            ops_->move(storage_, other.storage_);
+            other.ops_ = nullptr;
+        }
+    }
+    unique_task& operator=(unique_task&& other) noexcept {
+        if (this != &other) {
+            reset();
+            if (other.ops_) {
+                other.ops_->move(storage_, other.storage_);
+                ops_ = std::exchange(other.ops_, nullptr);
+            }
+        }
+        return *this;
+    }
+    ~unique_task() {
+        reset();
+    }
+
+    void operator()() {
+        ops_->invoke(storage_);
+    }
+
+    bool valid() const noexcept { return ops_ != nullptr; }
+    explicit operator bool() const noexcept { return valid(); }
+
+    void reset() noexcept {
+        if (ops_)
+            std::exchange(ops_, nullptr)->destroy(storage_);
+    }
+
+private:
+    struct operations {
+        void (*invoke)(void*);
+        void (*move)(void* dst, void* src) noexcept; // 移动到 dst 并销毁 src
+        void (*destroy)(void*) noexcept;
+    };
+
+    // 移动构造必须 noexcept，否则队列扩容时无法保证强异常安全
+    template<typename Fn>
+    static constexpr bool fits_inline = sizeof(Fn) <= inline_size &&
+        alignof(Fn) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<Fn>;
+
+    template<typename Fn>
+    static Fn* object(void* p) noexcept {
+        return std::launder(static_cast<Fn*>(p));
+    }
+
+    template<typename Fn>
+    static constexpr operations inline_ops{
+        [](void* p) { (*object<Fn>(p))(); },
+        [](void* dst, void* src) noexcept {
+            ::new (dst) Fn(std::move(*object<Fn>(src)));
+            object<Fn>(src)->~Fn();
+        },
+        [](void* p) noexcept { object<Fn>(p)->~Fn(); }
+    };
+
+    template<typename Fn>
+    static constexpr operations heap_ops{
+        [](void* p) { (**object<Fn*>(p))(); },
+        [](void* dst, void* src) noexcept { ::new (dst) Fn*(*object<Fn*>(src)); },
+        [](void* p) noexcept { delete *object<Fn*>(p); }
+    };
+
+    alignas(std::max_align_t) unsigned char storage_[inline_size];
+    const operations* ops_ = nullptr;
+};
+
+// 续体在哪里执行。线程池提交任务时把自己填进去；为空时续体直接在完成前驱的线程上执行。
+// 只保存裸指针，登记了续体的 future 不能比它的线程池活得更久。
+struct task_executor {
+    void* context = nullptr;
+    void (*post)(void* context, unique_task&& task) = nullptr;
+
+    explicit operator bool() const noexcept { return post != nullptr; }
+    void operator()(unique_task&& task) const {
+        if (post)
+            post(context, std::move(task));
+        else
+            task();
+    }
+};
+
+template<typename R>
+class task_future;
+
+template<typename Sequence>
+struct when_any_result {
+    std::size_t index; // 第一个就绪的 future 的下标；输入为空时是 size_t(-1)
+    Sequence    futures;
+};
+
+namespace detail {
+
+// promise 和 future 共享的状态：引用计数、状态字、结果和续体放在同一块内存里，
+// 只分配一次（std::promise 还要额外的控制块和类型擦除的结果对象）。
+// 状态字 pending -> waiting（已登记续体）-> ready，谁后到谁负责执行续体，不需要锁。
+template<typename R>
+class task_state {
+public:
+    using value_type = std::conditional_t<std::is_void_v<R>, std::monostate,
+        std::conditional_t<std::is_reference_v<R>, std::remove_reference_t<R>*, R>>;
+
+    explicit task_state(task_executor executor) noexcept : executor_{ executor } {}
+
+    void add_ref() noexcept {
+        refs_.fetch_add(1, std::memory_order_relaxed);
+    }
+    void release() noexcept {
+        if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete this;
+    }
+
+    template<typename ...V>
+    void set_value(V&&... value) {
+        if constexpr (std::is_reference_v<R>)
+            result_.template emplace<1>(std::addressof(value)...);
+        else
+            result_.template emplace<1>(std::forward<V>(value)...);
+        publish();
+    }
+    void set_exception(std::exception_ptr e) noexcept {
+        result_.template emplace<2>(std::move(e));
+        publish();
+    }
+
+    bool ready() const noexcept {
+        return status_.load(std::memory_order_acquire) == ready_status;
+    }
+    void wait() const noexcept {
+        for (auto s = status_.load(std::memory_order_acquire); s != ready_status; s = status_.load(std::memory_order_acquire))
+            status_.wait(s, std::memory_order_acquire);
+    }
+
+    R get() {
+        wait();
+        if (result_.index() == 2)
+            std::rethrow_exception(std::get<2>(result_));
+        if constexpr (std::is_void_v<R>)
+            return;
+        else if constexpr (std::is_reference_v<R>)
+            return static_cast<R>(*std::get<1>(result_));
+        else
+            return std::move(std::get<1>(result_));
+    }
+
+    // 就绪后调用 c（已经就绪则立即在当前线程调用）。每个状态只能登记一次。
+    // c 在完成前驱的线程上运行，应当很短，真正的工作交给 executor()。
+    void set_continuation(unique_task c) {
+        continuation_ = std::move(c);
+        auto expected = pending_status;
+        if (!status_.compare_exchange_strong(expected, waiting_status, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            unique_task run = std::move(continuation_);
+            run();
+        }
+    }
+
+    const task_executor& executor() const noexcept { return executor_; }
+
+private:
+    static constexpr std::uint32_t pending_status = 0;
+    static constexpr std::uint32_t waiting_status = 1;
+    static constexpr std::uint32_t ready_status   = 2;
+
+    void publish() noexcept {
+        auto previous = status_.exchange(ready_status, std::memory_order_acq_rel);
+        status_.notify_all();
+        if (previous == waiting_status) {
+            unique_task run = std::move(continuation_);
+            run();
+        }
+    }
+
+    std::atomic<std::uint32_t> refs_{ 2 }; // 一个 promise，一个 future
+    std::atomic<std::uint32_t> status_{ pending_status };
+    task_executor              executor_;
+    unique_task                continuation_;
+    std::variant<std::monostate, value_type, std::exception_ptr> result_;
+};
+
+template<typename R, typename F>
+struct then_result {
+    using type = std::invoke_result_t<F, R>;
+};
+template<typename F>
+struct then_result<void, F> {
+    using type = std::invoke_result_t<F>;
+};
+
+// f 返回 task_future<V> 时 then 的结果展开成 task_future<V>
+template<typename T>
+struct unwrap_future {
+    using type = T;
+};
+template<typename T>
+struct unwrap_future<task_future<T>> {
+    using type = T;
+};
+
+template<typename T>
+inline constexpr bool is_task_future = false;
+template<typename T>
+inline constexpr bool is_task_future<task_future<T>> = true;
+
+// 组合子需要直接操作共享状态
+struct future_access {
+    template<typename R>
+    static task_state<R>* state(const task_future<R>& future) noexcept {
+        return future.state_;
+    }
+};
+
+} // namespace detail
+
+// 写端。未设置结果就被销毁（比如线程池停止时丢弃了任务）时，future 会得到 broken_promise。
+template<typename R>
+class task_promise {
+public:
+    task_promise() noexcept = default;
+    task_promise(task_promise&& other) noexcept : state_{ std::exchange(other.state_, nullptr) } {}
+    task_promise& operator=(task_promise&& other) noexcept {
+        if (this != &other) {
+            abandon();
+            state_ = std::exchange(other.state_, nullptr);
+        }
+        return *this;
+    }
+    ~task_promise() {
+        abandon();
+    }
+
+    template<typename ...V>
+    void set_value(V&&... value) {
+        state_->set_value(std::forward<V>(value)...);
+        std::exchange(state_, nullptr)->release();
+    }
+    void set_exception(std::exception_ptr e) noexcept {
+        state_->set_exception(std::move(e));
+        std::exchange(state_, nullptr)->release();
+    }
+
+    // 调用 fn，把返回值或异常交给 future
+    template<typename Fn>
+    void fulfill(Fn&& fn) noexcept {
+        detail::task_state<R>* state = std::exchange(state_, nullptr);
+        try {
+            if constexpr (std::is_void_v<R>) {
+                std::invoke(std::forward<Fn>(fn));
+                state->set_value();
+            }
+            else {
+                state->set_value(std::invoke(std::forward<Fn>(fn)));
+            }
+        }
+        catch (...) {
+            state->set_exception(std::current_exception());
+        }
+        state->release();
+    }
+
+private:
+    template<typename T>
+    friend std::pair<task_promise<T>, task_future<T>> make_task_promise(task_executor);
+
+    explicit task_promise(detail::task_state<R>* state) noexcept : state_{ state } {}
+
+    void abandon() noexcept {
+        if (!state_)
+            return;
+        state_->set_exception(std::make_exception_ptr(std::future_error{ std::future_errc::broken_promise }));
+        std::exchange(state_, nullptr)->release();
+    }
+
+    detail::task_state<R>* state_ = nullptr;
+};
+
+// 读端，接口是 std::future 的子集：get 只能调用一次，之后 valid() 为 false。
+// then 登记续体后 future 也失效，结果通过返回的新 future 取得。
+template<typename R>
+class task_future {
+public:
+    task_future() noexcept = default;
+    task_future(task_future&& other) noexcept : state_{ std::exchange(other.state_, nullptr) } {}
+    task_future& operator=(task_future&& other) noexcept {
+        if (this != &other) {
+            if (state_)
+                state_->release();
+            state_ = std::exchange(other.state_, nullptr);
+        }
+        return *this;
+    }
+    ~task_future() {
+        if (state_)
+            state_->release();
+    }
+
+    bool valid() const noexcept { return state_ != nullptr; }
+    bool is_ready() const noexcept { return state_->ready(); }
+    void wait() const noexcept { state_->wait(); }
+
+    R get() {
+        struct releaser {
+            detail::task_state<R>* state;
+            ~releaser() { state->release(); }
+        } guard{ std::exchange(state_, nullptr) };
+        return guard.state->get();
+    }
+
+    // 就绪后把 f(结果) 投递到提交这个任务的线程池（没有线程池时在完成它的线程上执行），
+    // 不阻塞任何线程。前驱抛出的异常直接传给返回的 future，f 不会被调用。
+    // f 返回 task_future<V> 时，结果展开为 task_future<V>。
+    template<typename F>
+    task_future<typename detail::unwrap_future<typename detail::then_result<R, std::decay_t<F>>::type>::type> then(F&& f) {
+        using U = typename detail::then_result<R, std::decay_t<F>>::type;
+        using V = typename detail::unwrap_future<U>::type;
+
+        // 前驱的 future 跟着续体走：续体被丢弃（比如线程池已停止）时照样释放前驱的状态
+        task_executor executor = state_->executor();
+        auto [promise, future] = make_task_promise<V>(executor);
+        detail::task_state<R>* state = state_;
+        state->set_continuation([executor, antecedent = std::move(*this), promise = std::move(promise), f = std::forward<F>(f)]() mutable {
+            executor([antecedent = std::move(antecedent), promise = std::move(promise), f = std::move(f)]() mutable {
+                auto call = [&]() -> U {
+                    if constexpr (std::is_void_v<R>) {
+                        antecedent.get();
+                        return std::invoke(std::move(f));
+                    }
+                    else {
+                        return std::invoke(std::move(f), antecedent.get());
+                    }
+                };
+                if constexpr (detail::is_task_future<U>) {
+                    U inner;
+                    try {
+                        inner = call();
+                    }
+                    catch (...) {
+                        promise.set_exception(std::current_exception());
+                        return;
+                    }
+                    forward_to(std::move(inner), std::move(promise));
+                }
+                else {
+                    promise.fulfill(call);
+                }
+            });
+        });
+        return std::move(future);
+    }
+
+private:
+    template<typename T>
+    friend std::pair<task_promise<T>, task_future<T>> make_task_promise(task_executor);
+    template<typename T>
+    friend class task_future;
+    friend struct detail::future_access;
+
+    explicit task_future(detail::task_state<R>* state) noexcept : state_{ state } {}
+
+    // inner 就绪后把结果转交给 promise
+    template<typename V>
+    static void forward_to(task_future<V> inner, task_promise<V> promise) {
+        detail::task_state<V>* state = inner.state_;
+        state->set_continuation([inner = std::move(inner), promise = std::move(promise)]() mutable {
+            promise.fulfill([&]() -> V { return inner.get(); });
+        });
+    }
+
+    detail::task_state<R>* state_ = nullptr;
+};
+
+template<typename R>
+std::pair<task_promise<R>, task_future<R>> make_task_promise(task_executor executor = {}) {
+    auto* state = new detail::task_state<R>{ executor };
+    return { task_promise<R>{ state }, task_future<R>{ state } };
+}
+
+namespace detail {
+
+template<typename Sequence>
+struct when_all_block {
+    std::atomic<std::size_t> remaining;
+    Sequence                 futures;
+    task_promise<Sequence>   promise;
+
+    void arrive() {
+        if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            promise.set_value(std::move(futures));
+            delete this;
+        }
+    }
+};
+
+template<typename Sequence>
+struct when_any_block {
+    std::atomic<std::size_t>                 refs;
+    std::atomic<bool>                        done;
+    Sequence                                 futures;
+    task_promise<when_any_result<Sequence>>  promise;
+
+    void arrive(std::size_t index) {
+        if (!done.exchange(true, std::memory_order_acq_rel))
+            promise.set_value(when_any_result<Sequence>{ index, std::move(futures) });
+        if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete this;
+    }
+};
+
+template<typename R>
+task_executor executor_of(const task_future<R>& future) noexcept {
+    return future_access::state(future)->executor();
+}
+
+} // namespace detail
+
+// 所有输入都就绪时就绪，结果是原样交还的 future（各自的值或异常再逐个 get）。
+// 组合本身不占用任何线程，结果 future 的 then 投递到第一个输入所属的线程池。
+template<typename R>
+task_future<std::vector<task_future<R>>> when_all(std::vector<task_future<R>> futures) {
+    using sequence = std::vector<task_future<R>>;
+    task_executor executor = futures.empty() ? task_executor{} : detail::executor_of(futures.front());
+    auto [promise, result] = make_task_promise<sequence>(executor);
+    if (futures.empty()) {
+        promise.set_value(std::move(futures));
+        return std::move(result);
+    }
+
+    // 最后一个续体会移走 futures 并删除 block，所以先把状态指针取出来
+    std::vector<detail::task_state<R>*> states;
+    states.reserve(futures.size());
+    for (auto& future : futures)
+        states.push_back(detail::future_access::state(future));
+
+    auto* block = new detail::when_all_block<sequence>{ states.size(), std::move(futures), std::move(promise) };
+    for (auto* state : states)
+        state->set_continuation([block] { block->arrive(); });
+    return std::move(result);
+}
+
+template<typename ...R>
+task_future<std::tuple<task_future<R>...>> when_all(task_future<R>... futures) {
+    using sequence = std::tuple<task_future<R>...>;
+    task_executor executor;
+    if constexpr (sizeof...(R) != 0)
+        executor = detail::executor_of(std::get<0>(std::tie(futures...)));
+    auto [promise, result] = make_task_promise<sequence>(executor);
+    if constexpr (sizeof...(R) == 0) {
+        promise.set_value(sequence{});
+    }
+    else {
+        auto states = std::make_tuple(detail::future_access::state(futures)...);
+        auto* block = new detail::when_all_block<sequence>{ sizeof...(R), sequence{ std::move(futures)... }, std::move(promise) };
+        std::apply([block](auto*... state) { (state->set_continuation([block] { block->arrive(); }), ...); }, states);
+    }
+    return std::move(result);
+}
+
+// 任意一个输入就绪时就绪，结果带上它的下标和全部输入 future。
+template<typename R>
+task_future<when_any_result<std::vector<task_future<R>>>> when_any(std::vector<task_future<R>> futures) {
+    using sequence = std::vector<task_future<R>>;
+    task_executor executor = futures.empty() ? task_executor{} : detail::executor_of(futures.front());
+    auto [promise, result] = make_task_promise<when_any_result<sequence>>(executor);
+    if (futures.empty()) {
+        promise.set_value(when_any_result<sequence>{ static_cast<std::size_t>(-1), std::move(futures) });
+        return std::move(result);
+    }
+
+    // 第一个续体就会移走 futures，而调用者随后可能销毁它们，
+    // 所以登记期间额外持有每个状态的引用
+    std::vector<detail::task_state<R>*> states;
+    states.reserve(futures.size());
+    for (auto& future : futures) {
+        states.push_back(detail::future_access::state(future));
+        states.back()->add_ref();
+    }
+
+    auto* block = new detail::when_any_block<sequence>{ states.size(), false, std::move(futures), std::move(promise) };
+    for (std::size_t i = 0; i < states.size(); ++i)
+        states[i]->set_continuation([block, i] { block->arrive(i); });
+    for (auto* state : states)
+        state->release();
+    return std::move(result);
+}
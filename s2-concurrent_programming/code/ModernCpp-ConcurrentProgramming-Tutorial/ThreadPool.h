@@ -0,0 +1,1236 @@
+#pragma once
+
+#include "CpuRelax.h"
+#include "CpuTopology.h"
+#include "Histogram.h"
+#include "Task.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <latch>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// 本进程实际能用的 CPU 数（受 taskset/cgroup 限制后的亲和性掩码），而不是整台机器的核数
+inline std::size_t default_thread_pool_size() noexcept{
+    std::size_t num_threads = cpu_topology::get().cpus().size();
+    num_threads = num_threads == 0 ? 2 : num_threads; // 防止无法检测当前硬件，让我们线程池至少有 2 个线程
+    return num_threads;
+}
+
+// Chase-Lev 工作窃取双端队列（Lê 等人 2013 年给出的 C11 内存序版本）
+// 拥有者线程在 bottom 端 push/pop（LIFO），其它线程从 top 端 steal（FIFO）。
+// 元素必须可平凡复制（一般是指针），因为窃取者读到的值可能随后被作废。
+template<typename T>
+class chase_lev_deque {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    struct ring {
+        explicit ring(std::int64_t capacity) :
+            capacity{ capacity }, slots{ std::make_unique<std::atomic<T>[]>(capacity) } {}
+
+        T load(std::int64_t i) const noexcept {
+            return slots[i & (capacity - 1)].load(std::memory_order_relaxed);
+        }
+        void store(std::int64_t i, T value) noexcept {
+            slots[i & (capacity - 1)].store(value, std::memory_order_relaxed);
+        }
+
+        std::int64_t                       capacity; // 2 的幂
+        std::unique_ptr<std::atomic<T>[]>  slots;
+    };
+
+public:
+    explicit chase_lev_deque(std::int64_t capacity = 256) {
+        rings_.push_back(std::make_unique<ring>(capacity));
+        ring_.store(rings_.back().get(), std::memory_order_relaxed);
+    }
+    chase_lev_deque(const chase_lev_deque&) = delete;
+    chase_lev_deque& operator=(const chase_lev_deque&) = delete;
+
+    // 只能由拥有者线程调用
+    void push(T value) {
+        std::int64_t b = bottom_.load(std::memory_order_relaxed);
+        std::int64_t t = top_.load(std::memory_order_acquire);
+        ring* r = ring_.load(std::memory_order_relaxed);
+        if (b - t > r->capacity - 1) {
+            r = grow_(r, t, b);
+        }
+        r->store(b, value);
+        bottom_.store(b + 1, std::memory_order_release); // 与 steal 中 bottom_ 的 acquire 配对
+    }
+
+    // 只能由拥有者线程调用
+    std::optional<T> pop() {
+        std::int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        ring* r = ring_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = top_.load(std::memory_order_relaxed);
+
+        std::optional<T> result;
+        if (t <= b) {
+            result = r->load(b);
+            if (t == b) { // 最后一个元素，和窃取者竞争
+                if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    result.reset();
+                bottom_.store(b + 1, std::memory_order_relaxed);
+            }
+        }
+        else {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+        }
+        return result;
+    }
+
+    // 任意线程都可以调用；失败（队列空或竞争失败）返回空
+    std::optional<T> steal() {
+        std::int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t b = bottom_.load(std::memory_order_acquire);
+        if (t >= b)
+            return std::nullopt;
+
+        ring* r = ring_.load(std::memory_order_acquire);
+        T value = r->load(t);
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return std::nullopt;
+        return value;
+    }
+
+    // 近似值，只用于判断要不要去偷、要不要睡眠或者要不要加线程
+    bool empty() const noexcept {
+        return size() == 0;
+    }
+    std::size_t size() const noexcept {
+        std::int64_t n = bottom_.load(std::memory_order_relaxed) - top_.load(std::memory_order_relaxed);
+        return n > 0 ? static_cast<std::size_t>(n) : 0;
+    }
+
+private:
+    ring* grow_(ring* old, std::int64_t t, std::int64_t b) {
+        auto bigger = std::make_unique<ring>(old->capacity * 2);
+        for (std::int64_t i = t; i < b; ++i)
+            bigger->store(i, old->load(i));
+        ring* r = bigger.get();
+        rings_.push_back(std::move(bigger)); // 旧的环不能立即释放，窃取者可能还在读它
+        ring_.store(r, std::memory_order_release);
+        return r;
+    }
+
+    alignas(64) std::atomic<std::int64_t> top_{ 0 };
+    alignas(64) std::atomic<std::int64_t> bottom_{ 0 };
+    alignas(64) std::atomic<ring*>        ring_{ nullptr };
+    std::vector<std::unique_ptr<ring>>    rings_;
+};
+
+class ThreadPool{
+public:
+    using Task = unique_task;
+
+    enum class mode {
+        fifo,          // 所有线程共享一个加锁的队列
+        work_stealing  // 每个线程一个 Chase-Lev 双端队列，空闲时随机偷别人的任务
+    };
+
+    // 工作线程放在哪些 CPU 上
+    enum class placement {
+        none,      // 不绑定，由操作系统调度
+        compact,   // 依次绑定到同一节点、同一核心的相邻 CPU 上，共享缓存最多
+        scatter,   // 在节点和物理核心之间轮流绑定，内存带宽和缓存总量最大
+        numa_nodes // 每个 NUMA 节点一个子线程池：线程绑定到节点的 CPU 集合，有自己的全局队列，
+                   // 提交的任务进提交者所在节点的队列；某个节点忙不过来时唤醒别的节点的空闲线程来帮忙
+    };
+
+    using clock = std::chrono::steady_clock;
+
+    enum class priority : std::uint8_t {
+        high,   // 延迟敏感的任务
+        normal,
+        low     // 后台批处理
+    };
+
+    // 提交选项，可以从 priority 隐式构造：pool.submit(ThreadPool::priority::high, f)
+    struct task_options {
+        task_options(priority prio = priority::normal, std::optional<clock::time_point> deadline = std::nullopt) noexcept :
+            prio{ prio }, deadline{ deadline } {}
+
+        bool is_default() const noexcept { return prio == priority::normal && !deadline; }
+
+        priority                         prio;
+        std::optional<clock::time_point> deadline; // 同一优先级内截止时间最早的先执行（EDF），过期也不会丢弃
+    };
+
+    // 线程数和空闲策略。线程数在 [min_threads, max_threads] 之间伸缩，两者相等就是固定大小的线程池。
+    struct elastic_options {
+        std::size_t     min_threads      = 1;
+        std::size_t     max_threads      = default_thread_pool_size();
+        clock::duration spin_time        = std::chrono::microseconds{ 50 }; // 没活干后先自旋等这么久再睡眠，0 表示直接睡眠
+        clock::duration idle_timeout     = std::chrono::seconds{ 1 };       // 睡眠这么久还没活干就退出（保留 min_threads 个）
+        std::size_t     grow_queue_depth = 2;                               // 没有空闲线程且积压这么多任务时加一个线程
+    };
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ThreadPool(std::size_t num_thread = default_thread_pool_size(), mode m = mode::fifo, placement p = placement::none) :
+        ThreadPool(elastic_options{ num_thread, num_thread }, m, p) {}
+
+    explicit ThreadPool(elastic_options options, mode m = mode::fifo, placement p = placement::none) :
+        stop_{ false }, num_thread_{ 0 }, mode_{ m }, elastic_{ options }
+    {
+        if (elastic_.min_threads == 0 || elastic_.max_threads < elastic_.min_threads)
+            throw std::invalid_argument("ThreadPool needs 1 <= min_threads <= max_threads");
+        place_workers(p);
+        metrics_ = std::make_unique<slot_metrics[]>(elastic_.max_threads + 1);
+        start();
+    }
+    ~ThreadPool(){
+        stop();
+    }
+
+    void stop(){
+        stop_ = true;
+        for (std::size_t n = 0; n < num_nodes_; ++n) {
+            // 修改后持一次锁，避免工作线程检查完谓词、还没进入 wait 时错过通知
+            { std::lock_guard<std::mutex> lc{ nodes_[n].mutex }; }
+            nodes_[n].cv.notify_all();
+        }
+        std::vector<std::thread> threads;
+        {
+            std::lock_guard<std::mutex> lc{ grow_mutex_ };
+            threads.swap(pool_);
+            pool_.resize(threads.size());
+            retired_.clear();
+        }
+        for (auto& thread : threads){
+            if (thread.joinable())
+                thread.join();
+        }
+        for (std::size_t i = 0; i < num_queues_; ++i) {
+            while (auto task = queues_[i].deque.pop())
+                delete *task;
+        }
+    }
+
+    // 当前的工作线程数
+    std::size_t thread_count() const noexcept {
+        return num_thread_.load(std::memory_order_relaxed);
+    }
+
+    const elastic_options& options() const noexcept {
+        return elastic_;
+    }
+
+    // 一个线程槽位的统计
+    struct worker_metrics {
+        bool                     running; // 槽位上现在有没有线程
+        std::uint64_t            tasks;
+        std::uint64_t            steals;  // 从别的线程的双端队列偷来执行的任务数，只有工作窃取模式才有
+        std::chrono::nanoseconds busy;    // 执行任务的时间
+        std::chrono::nanoseconds alive;   // 线程活着的时间，槽位上先后有过多个线程时是它们之和
+
+        // 忙碌时间占比，其余时间在自旋、睡眠或找任务
+        double utilization() const noexcept {
+            return alive.count() == 0 ? 0.0 : static_cast<double>(busy.count()) / static_cast<double>(alive.count());
+        }
+    };
+
+    // metrics() 的结果。计数和直方图都从线程池创建时开始累计，导出时用两次快照的差算速率。
+    // 各项分别读取，不是同一瞬间的一致视图。
+    struct metrics_snapshot {
+        std::size_t                 threads;
+        std::size_t                 queue_depth;      // 正在排队的任务数，各队列之和
+        std::size_t                 peak_queue_depth; // 单个队列出现过的最大积压
+        std::uint64_t               tasks;            // 执行完的任务数，包括外部线程帮忙执行的
+        std::uint64_t               steals;
+        histogram_snapshot          wait;             // 入队到开始执行
+        histogram_snapshot          exec;             // 执行时间
+        std::vector<worker_metrics> workers;          // 按线程槽位，长度为 max_threads
+    };
+
+    // 记录只是工作线程写自己槽位上的 relaxed 计数器，每个任务多读两次时钟，可以在生产环境一直开着
+    metrics_snapshot metrics() const {
+        metrics_snapshot s{};
+        s.threads = thread_count();
+        for (std::size_t n = 0; n < num_nodes_; ++n)
+            s.queue_depth += nodes_[n].tasks.size();
+        for (std::size_t i = 0; i < num_queues_; ++i)
+            s.queue_depth += queues_[i].deque.size();
+        s.peak_queue_depth = peak_depth_.load(std::memory_order_relaxed);
+        std::int64_t now = clock::now().time_since_epoch() / std::chrono::nanoseconds{ 1 };
+        for (std::size_t i = 0; i <= elastic_.max_threads; ++i) {
+            const slot_metrics& m = metrics_[i];
+            histogram_snapshot exec = m.exec.snapshot();
+            std::uint64_t steals = m.steals.load(std::memory_order_relaxed);
+            s.wait += m.wait.snapshot();
+            s.exec += exec;
+            s.steals += steals;
+            if (i == elastic_.max_threads)
+                break; // 最后一份属于外部线程，只计入总数
+            std::int64_t since = m.alive_since.load(std::memory_order_relaxed);
+            std::int64_t alive = m.alive_ns.load(std::memory_order_relaxed) + (since != 0 ? now - since : 0);
+            s.workers.push_back({ since != 0, exec.count, steals,
+                std::chrono::nanoseconds{ static_cast<std::int64_t>(exec.sum_ns) }, std::chrono::nanoseconds{ alive } });
+        }
+        s.tasks = s.exec.count;
+        return s;
+    }
+
+    // 开始新的一段观察期，返回之前的峰值
+    std::size_t reset_peak_queue_depth() noexcept {
+        return peak_depth_.exchange(0, std::memory_order_relaxed);
+    }
+
+    // 参数按值保存，需要引用时用 std::ref。
+    // 只分配一次：promise/future 的共享状态；可调用对象和参数放在 Task 的内部缓冲区里（放不下才另外分配）。
+    template<typename F, typename ...Args>
+    task_future<std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>> submit(F&& f, Args&&...args){
+        return submit(task_options{}, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    // 指定优先级或截止时间提交。非默认选项的任务总是进入全局队列，工作窃取模式下也不放进本地队列。
+    template<typename F, typename ...Args>
+    task_future<std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>> submit(task_options options, F&& f, Args&&...args){
+        using RetType = std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>;
+        if(stop_){
+            throw std::runtime_error("ThreadPool is stopped");
+        }
+        auto [promise, ret] = make_task_promise<RetType>(executor());
+        enqueue([promise = std::move(promise), f = std::forward<F>(f), ...args = std::forward<Args>(args)]() mutable {
+            promise.fulfill([&]() -> RetType { return std::invoke(std::move(f), std::move(args)...); });
+        }, options);
+        return std::move(ret);
+    }
+
+    // 发射后不管，不需要结果时用它：小的可调用对象完全不分配内存。
+    // 任务抛出的异常不会被捕获（和 std::thread 一样会调用 std::terminate）。
+    template<typename F>
+    void post(F&& f){
+        post(task_options{}, std::forward<F>(f));
+    }
+
+    template<typename F>
+    void post(task_options options, F&& f){
+        if(stop_){
+            throw std::runtime_error("ThreadPool is stopped");
+        }
+        enqueue(Task{ std::forward<F>(f) }, options);
+    }
+
+    // co_await pool.schedule() 把当前协程挂起，作为一个任务放进线程池，在工作线程上恢复。
+    // 任务只捕获协程句柄，不分配共享状态。线程池已停止时在 co_await 处抛出异常；
+    // stop() 时还在队列里的恢复会被丢弃，所以线程池要比调度到它上面的协程活得更久。
+    struct schedule_awaiter {
+        ThreadPool*  pool;
+        task_options options;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> awaiting) const {
+            if (pool->stop_)
+                throw std::runtime_error("ThreadPool is stopped");
+            pool->enqueue(Task{ [awaiting] { awaiting.resume(); } }, options);
+        }
+        void await_resume() const noexcept {}
+    };
+
+    schedule_awaiter schedule(task_options options = {}) noexcept {
+        return { this, options };
+    }
+
+    // task_future::then 的续体通过它投递回本线程池（默认选项，工作线程上投递时进本地队列）
+    task_executor executor() noexcept {
+        return { this, [](void* pool, Task&& task) { static_cast<ThreadPool*>(pool)->enqueue(std::move(task)); } };
+    }
+
+    // 低优先级任务每等待这么久就提升一级参与调度，防止被饿死；没有截止时间的任务也以
+    // “入队时间 + 该值”作为截止时间和同一级的 EDF 任务比较。默认 10ms。
+    void set_aging_threshold(clock::duration aging){
+        if (aging <= clock::duration::zero())
+            throw std::invalid_argument("aging threshold must be positive");
+        for (std::size_t n = 0; n < num_nodes_; ++n) {
+            std::lock_guard<std::mutex> lc{ nodes_[n].mutex };
+            nodes_[n].tasks.set_aging(aging);
+        }
+    }
+
+    // 一次提交一批任务，只加一次锁、唤醒一次。callables 中的元素会被移走。
+    template<typename F>
+    std::vector<task_future<std::invoke_result_t<F>>> submit_bulk(std::span<F> callables){
+        using RetType = std::invoke_result_t<F>;
+        if(stop_){
+            throw std::runtime_error("ThreadPool is stopped");
+        }
+        std::vector<task_future<RetType>> futures;
+        std::vector<Task> tasks;
+        futures.reserve(callables.size());
+        tasks.reserve(callables.size());
+        for (F& f : callables) {
+            auto [promise, future] = make_task_promise<RetType>(executor());
+            tasks.emplace_back([promise = std::move(promise), f = std::move(f)]() mutable {
+                promise.fulfill(std::move(f));
+            });
+            futures.push_back(std::move(future));
+        }
+        enqueue_bulk(tasks);
+        return futures;
+    }
+
+    // 并行执行 [first, last)。body 可以接受一个下标 body(i)，也可以接受一段 body(begin, end)。
+    // 区间按需二分（见 should_split），grain 是不再继续分割的最小段长，0 表示自动选择。
+    // 调用者自己也参与计算，在工作线程里嵌套调用也不会死锁。body 抛出的第一个异常在这里重新抛出。
+    template<std::integral I, typename Body>
+    void parallel_for(I first, I last, Body&& body, std::size_t grain = 0){
+        auto chunk = [&body](I begin, I end, std::monostate) {
+            if constexpr (std::is_invocable_v<Body&, I, I>) {
+                body(begin, end);
+            }
+            else {
+                for (I i = begin; i != end; ++i)
+                    body(i);
+            }
+            return std::monostate{};
+        };
+        parallel_reduce(first, last, std::monostate{}, chunk, [](std::monostate, std::monostate) { return std::monostate{}; }, grain);
+    }
+
+    // body(begin, end, acc) 把一段累加进 acc 并返回，reduce(a, b) 合并两个部分结果。
+    // 和 std::reduce 一样，部分结果的合并顺序不确定，reduce 需要满足结合律和交换律。
+    template<std::integral I, typename T, typename Body, typename Reduce>
+    T parallel_reduce(I first, I last, T identity, Body&& body, Reduce&& reduce, std::size_t grain = 0){
+        if (!(first < last))
+            return identity;
+        auto size = static_cast<std::size_t>(last - first);
+        if (grain == 0)
+            grain = std::max<std::size_t>(1, size / (num_thread_ * 8));
+
+        range_job<I, T, std::remove_reference_t<Body>, std::remove_reference_t<Reduce>> job{
+            static_cast<std::ptrdiff_t>(size), grain, identity, body, reduce };
+        job.run(*this, first, last);
+        help_until(job.done);
+        if (job.error)
+            std::rethrow_exception(job.error);
+        return std::move(job.result);
+    }
+
+    void start(){
+        if (mode_ == mode::work_stealing && !queues_) {
+            num_queues_ = elastic_.max_threads; // 每个线程槽位一个双端队列，槽位空着时队列也是空的
+            queues_ = std::make_unique<worker_queue[]>(num_queues_);
+        }
+        std::lock_guard<std::mutex> lc{ grow_mutex_ };
+        pool_.resize(elastic_.max_threads);
+        for (std::size_t i = 0; i < elastic_.min_threads; ++i)
+            spawn_worker(i);
+    }
+
+private:
+    struct queued_task {
+        Task              task;
+        clock::time_point enqueued;
+        clock::time_point deadline;
+    };
+
+    // 容量按 2 的幂增长的环形缓冲区，稳定后入队出队都不分配内存
+    // （std::deque 每 512 字节一块，会随着入队出队不断申请和释放）
+    class task_ring {
+    public:
+        bool empty() const noexcept { return head_ == tail_; }
+        std::size_t size() const noexcept { return tail_ - head_; }
+
+        void push(queued_task&& task) {
+            if (size() == slots_.size())
+                grow();
+            slots_[tail_++ & (slots_.size() - 1)] = std::move(task);
+        }
+        const queued_task& front() const noexcept {
+            return slots_[head_ & (slots_.size() - 1)];
+        }
+        queued_task pop() noexcept {
+            return std::move(slots_[head_++ & (slots_.size() - 1)]);
+        }
+
+    private:
+        void grow() {
+            std::vector<queued_task> bigger(std::max<std::size_t>(64, slots_.size() * 2));
+            for (std::size_t i = head_; i != tail_; ++i)
+                bigger[i - head_] = std::move(slots_[i & (slots_.size() - 1)]);
+            tail_ -= head_;
+            head_ = 0;
+            slots_.swap(bigger);
+        }
+
+        std::vector<queued_task> slots_;
+        std::size_t              head_ = 0;
+        std::size_t              tail_ = 0;
+    };
+
+    // 全局队列：每个优先级一条车道。车道内是 FIFO 环形缓冲区加一个按截止时间排序的堆，
+    // 没有截止时间的任务视为在“入队时间 + aging”到期，两者中截止时间最早的先出队（EDF）。
+    // 车道之间比较有效优先级：队首每等待一个 aging 就提升一级（老化），相同时优先级高的先出。
+    // 除 has_urgent 外都要在线程池的锁内调用。
+    class task_lanes {
+    public:
+        // size/empty 和 has_urgent 也可以不加锁读取，只作提示
+        bool empty() const noexcept { return size() == 0; }
+        std::size_t size() const noexcept { return size_.load(std::memory_order_relaxed); }
+
+        // 是否有高优先级任务，或者截止时间不到一个 aging 的任务在排队。后者比刚提交的默认任务
+        // （视为入队时间 + aging 到期）更急，工作线程不该先执行自己队列里的任务
+        bool has_urgent() const noexcept {
+            if (urgent_.load(std::memory_order_relaxed) != 0)
+                return true;
+            auto from = urgent_from_.load(std::memory_order_relaxed);
+            return from != no_deadline && clock::now().time_since_epoch().count() >= from;
+        }
+
+        void set_aging(clock::duration aging) noexcept {
+            aging_ = aging;
+            update_urgent_from();
+        }
+
+        void push(Task&& task, const task_options& options) {
+            auto now = clock::now();
+            lane& l = lanes_[static_cast<std::size_t>(options.prio)];
+            if (options.deadline) {
+                l.edf.push_back({ std::move(task), now, *options.deadline });
+                std::push_heap(l.edf.begin(), l.edf.end(), later_deadline);
+                update_urgent_from();
+            }
+            else {
+                l.fifo.push({ std::move(task), now, now + aging_ });
+            }
+            size_.store(size() + 1, std::memory_order_relaxed);
+            if (options.prio == priority::high)
+                urgent_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // 队列不能为空。连同入队时间一起返回
+        queued_task pop() {
+            auto now = clock::now();
+            std::size_t best = lane_count;
+            std::int64_t best_rank = 0;
+            for (std::size_t i = 0; i < lane_count; ++i) {
+                const queued_task* head = lanes_[i].head();
+                if (head == nullptr)
+                    continue;
+                auto rank = static_cast<std::int64_t>(i) - static_cast<std::int64_t>((now - head->enqueued) / aging_);
+                if (best == lane_count || rank < best_rank) {
+                    best = i;
+                    best_rank = rank;
+                }
+            }
+            size_.store(size() - 1, std::memory_order_relaxed);
+            if (best == static_cast<std::size_t>(priority::high))
+                urgent_.fetch_sub(1, std::memory_order_relaxed);
+            queued_task task = lanes_[best].pop_head();
+            if (urgent_from_.load(std::memory_order_relaxed) != no_deadline)
+                update_urgent_from();
+            return task;
+        }
+
+    private:
+        static constexpr std::size_t lane_count = 3;
+        static constexpr clock::rep  no_deadline = std::numeric_limits<clock::rep>::max();
+
+        // 最早的截止时间减去 aging，从这一刻起 has_urgent 返回 true
+        void update_urgent_from() noexcept {
+            clock::rep from = no_deadline;
+            for (const lane& l : lanes_) {
+                if (!l.edf.empty())
+                    from = std::min(from, (l.edf.front().deadline - aging_).time_since_epoch().count());
+            }
+            urgent_from_.store(from, std::memory_order_relaxed);
+        }
+
+        static bool later_deadline(const queued_task& a, const queued_task& b) noexcept {
+            return a.deadline > b.deadline;
+        }
+
+        struct lane {
+            task_ring                fifo;
+            std::vector<queued_task> edf; // 以 later_deadline 为比较的堆，堆顶截止时间最早
+
+            bool edf_first() const noexcept {
+                return !edf.empty() && (fifo.empty() || edf.front().deadline < fifo.front().deadline);
+            }
+            const queued_task* head() const noexcept {
+                if (edf_first())
+                    return &edf.front();
+                return fifo.empty() ? nullptr : &fifo.front();
+            }
+            queued_task pop_head() {
+                if (!edf_first())
+                    return fifo.pop();
+                std::pop_heap(edf.begin(), edf.end(), later_deadline);
+                queued_task task = std::move(edf.back());
+                edf.pop_back();
+                return task;
+            }
+        };
+
+        lane                     lanes_[lane_count];
+        std::atomic<std::size_t> size_{ 0 };
+        std::atomic<std::size_t> urgent_{ 0 };
+        std::atomic<clock::rep>  urgent_from_{ no_deadline };
+        clock::duration          aging_ = std::chrono::milliseconds{ 10 };
+    };
+
+    // 一个节点的全局队列和睡眠在上面的工作线程。不用 NUMA 子线程池时只有一个节点。
+    struct alignas(64) node_queue {
+        std::mutex               mutex;
+        std::condition_variable  cv;
+        task_lanes               tasks;
+        std::atomic<std::size_t> sleepers{ 0 }; // 在 cv 上等待的工作线程数，持锁修改，别的节点可以不加锁读
+        std::size_t              spills = 0;    // 别的节点请本节点的线程去帮忙的次数，持锁访问
+        std::atomic<std::size_t> spinning{ 0 }; // 正在自旋等任务的工作线程数，有的话入队时不必唤醒睡眠者
+    };
+
+    // 放进双端队列的任务，带着入队时间
+    struct local_task {
+        Task              task;
+        clock::time_point enqueued;
+    };
+
+    struct alignas(64) worker_queue {
+        chase_lev_deque<local_task*> deque;
+        std::uint32_t          ticks = 0; // 只由拥有者线程访问
+    };
+
+    // 双端队列只能存指针。节点放在线程局部的空闲表里复用，稳定运行后不再分配；
+    // 被偷走的节点由窃取者回收进自己的空闲表。
+    struct node_cache {
+        static constexpr std::size_t max_nodes = 1024;
+        std::vector<local_task*> free;
+        ~node_cache() {
+            for (local_task* node : free)
+                delete node;
+        }
+    };
+    inline static thread_local node_cache node_cache_;
+
+    static local_task* acquire_node(Task&& task, clock::time_point enqueued) {
+        auto& free = node_cache_.free;
+        if (free.empty())
+            return new local_task{ std::move(task), enqueued };
+        local_task* node = free.back();
+        free.pop_back();
+        node->task = std::move(task);
+        node->enqueued = enqueued;
+        return node;
+    }
+
+    // 每个线程槽位一份统计，只由槽位上的线程写（槽位复用前旧线程已经被 join）；最后一份给帮忙执行
+    // 任务的外部线程（help_until），可能被多个线程同时写，要用原子加法。缓存行对齐，槽位之间不会伪共享。
+    struct alignas(64) slot_metrics {
+        latency_histogram          wait;
+        latency_histogram          exec;
+        std::atomic<std::uint64_t> steals{ 0 };
+        std::atomic<std::int64_t>  alive_ns{ 0 };    // 已经退出的线程活过的时间
+        std::atomic<std::int64_t>  alive_since{ 0 }; // 现在的线程启动的时刻（clock 纪元起的纳秒），0 表示没有线程
+    };
+
+    // 执行一个任务并记录它的排队时间和执行时间。工作线程接连执行任务时把上一个任务的结束时刻
+    // 当作这一个的开始，每个任务只读一次时钟；代价是取任务的开销算进了执行时间。
+    void run_task(Task& task, clock::time_point enqueued) {
+        bool worker = current_.pool == this;
+        slot_metrics& m = metrics_[worker ? current_.index : elastic_.max_threads];
+        auto start = worker && current_.last_finished != clock::time_point{} ? std::max(current_.last_finished, enqueued) : clock::now();
+        if (worker) {
+            m.wait.record_single_writer(start - enqueued);
+            current_.last_finished = {}; // 任务里嵌套执行的任务（parallel_for 等待时帮忙）要自己读时钟
+        }
+        else {
+            m.wait.record(start - enqueued);
+        }
+        task();
+        auto end = clock::now();
+        if (worker) {
+            m.exec.record_single_writer(end - start);
+            current_.last_finished = end;
+        }
+        else {
+            m.exec.record(end - start);
+        }
+    }
+
+    // 入队后看一眼这个队列的长度，只在创出新高时才写共享的峰值
+    void note_queue_depth(std::size_t depth) noexcept {
+        std::size_t peak = peak_depth_.load(std::memory_order_relaxed);
+        while (depth > peak && !peak_depth_.compare_exchange_weak(peak, depth, std::memory_order_relaxed)) {}
+    }
+
+    void run_node(local_task* node) {
+        run_task(node->task, node->enqueued);
+        node->task.reset(); // 尽早释放任务捕获的资源
+        if (node_cache_.free.size() < node_cache::max_nodes)
+            node_cache_.free.push_back(node);
+        else
+            delete node;
+    }
+
+    // parallel_reduce 的共享状态，放在调用者的栈上；调用者等所有迭代都计数完才返回
+    template<typename I, typename T, typename Body, typename Reduce>
+    struct range_job {
+        range_job(std::ptrdiff_t size, std::size_t grain, const T& identity, Body& body, Reduce& reduce) :
+            done{ size }, grain{ grain }, identity{ identity }, body{ body }, reduce{ reduce }, result{ identity } {}
+
+        // 每个任务先在局部变量里累加自己处理的所有段，结束时合并一次，最后才计数
+        void run(ThreadPool& pool, I first, I last) {
+            T acc = identity;
+            std::ptrdiff_t finished = 0;
+            while (first < last) {
+                auto size = static_cast<std::size_t>(last - first);
+                if (size > grain && pool.should_split()) {
+                    I middle = first + static_cast<I>(size / 2);
+                    pool.enqueue([this, &pool, middle, last] { run(pool, middle, last); });
+                    last = middle;
+                    continue;
+                }
+                I end = first + static_cast<I>(std::min(size, grain));
+                if (!failed.load(std::memory_order_relaxed)) {
+                    try {
+                        acc = body(first, end, std::move(acc));
+                    }
+                    catch (...) {
+                        std::lock_guard<std::mutex> lc{ mutex };
+                        if (!error)
+                            error = std::current_exception();
+                        failed.store(true, std::memory_order_relaxed);
+                    }
+                }
+                finished += static_cast<std::ptrdiff_t>(end - first);
+                first = end;
+            }
+            if constexpr (!std::is_same_v<T, std::monostate>) {
+                if (finished != 0 && !failed.load(std::memory_order_relaxed)) {
+                    std::lock_guard<std::mutex> lc{ mutex };
+                    result = reduce(std::move(result), std::move(acc));
+                }
+            }
+            done.count_down(finished);
+        }
+
+        std::latch        done;
+        std::size_t       grain;
+        const T&          identity;
+        Body&             body;
+        Reduce&           reduce;
+        std::atomic<bool> failed{ false }; // 出错后剩下的段只计数，不再执行
+        std::mutex        mutex;
+        T                 result;
+        std::exception_ptr error;
+    };
+
+    // 懒惰二分（lazy binary splitting）：工作窃取模式下，只有当前线程自己的队列空了
+    // （上次分出去的一半已经被别人偷走）才继续二分，没有空闲线程时就不产生多余的任务；
+    // 其它情况一直二分到 grain，由共享队列分发。
+    bool should_split() const noexcept {
+        if (mode_ == mode::work_stealing && current_.pool == this)
+            return queues_[current_.index].deque.empty();
+        return true;
+    }
+
+    // 等待期间帮忙执行队列里的任务。工作线程（嵌套并行）不能干等，否则可能所有线程都在等；
+    // 外部线程在队列空了之后就可以睡眠，剩下的段都在工作线程手里。
+    void help_until(std::latch& done) {
+        while (!done.try_wait()) {
+            if (run_pending_task())
+                continue;
+            if (current_.pool == this)
+                current_.last_finished = {};
+            if (current_.pool != this) {
+                done.wait();
+                return;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    bool run_pending_task() {
+        if (mode_ == mode::work_stealing && current_.pool == this) {
+            thread_local std::minstd_rand rng{ static_cast<unsigned>(current_.index + 1) };
+            return run_one(current_.index, rng);
+        }
+        return run_global();
+    }
+
+    bool run_global() {
+        queued_task task;
+        node_queue* node = pick_node();
+        if (node == nullptr)
+            return false;
+        {
+            std::lock_guard<std::mutex> lc{ node->mutex };
+            if (node->tasks.empty())
+                return false;
+            task = node->tasks.pop();
+        }
+        grow_if_backlogged(*node);
+        run_task(task.task, task.enqueued);
+        return true;
+    }
+
+    // 取走任务后队列里还积压着、又没有空闲线程时扩容。入队时看到的“睡眠者”可能已经被叫醒
+    // 只是还没开始运行，单靠入队时的判断在一批任务一起到达时会扩不起来。
+    void grow_if_backlogged(node_queue& node) noexcept {
+        if (num_thread_.load(std::memory_order_relaxed) >= elastic_.max_threads)
+            return;
+        if (node.sleepers.load(std::memory_order_relaxed) != 0 || node.spinning.load(std::memory_order_relaxed) != 0)
+            return;
+        maybe_grow(static_cast<std::size_t>(&node - nodes_.get()), node.tasks.size());
+    }
+
+    // 从哪个节点的全局队列取任务：有紧急任务（高优先级或截止时间临近）的节点优先，其次是自己的节点，
+    // 自己的节点空了再去别的节点（不加锁看一眼，都空时返回 nullptr）
+    node_queue* pick_node() noexcept {
+        std::size_t home = home_node();
+        if (num_nodes_ == 1)
+            return &nodes_[home];
+        for (std::size_t k = 0; k < num_nodes_; ++k) {
+            node_queue& node = nodes_[(home + k) % num_nodes_];
+            if (node.tasks.has_urgent())
+                return &node;
+        }
+        for (std::size_t k = 0; k < num_nodes_; ++k) {
+            node_queue& node = nodes_[(home + k) % num_nodes_];
+            if (!node.tasks.empty())
+                return &node;
+        }
+        return nullptr;
+    }
+
+    bool has_urgent() const noexcept {
+        for (std::size_t n = 0; n < num_nodes_; ++n) {
+            if (nodes_[n].tasks.has_urgent())
+                return true;
+        }
+        return false;
+    }
+
+    // 提交者所在的节点：工作线程是它所属的节点，其它线程看它当前运行在哪个 CPU 上
+    std::size_t home_node() const noexcept {
+        if (num_nodes_ == 1)
+            return 0;
+        if (current_.pool == this)
+            return worker_node_[current_.index];
+        int cpu = current_cpu();
+        return cpu >= 0 && static_cast<std::size_t>(cpu) < cpu_node_.size() ? cpu_node_[cpu] : 0;
+    }
+
+    void enqueue_bulk(std::span<Task> tasks) {
+        if (tasks.empty())
+            return;
+        if (mode_ == mode::work_stealing && current_.pool == this) {
+            auto now = clock::now();
+            for (Task& task : tasks)
+                queues_[current_.index].deque.push(acquire_node(std::move(task), now));
+            note_queue_depth(queues_[current_.index].deque.size());
+            std::atomic_thread_fence(std::memory_order_seq_cst); // 同 wake_one_if_sleeping
+            if (sleepers_.load(std::memory_order_relaxed) != 0) {
+                for (std::size_t n = 0; n < num_nodes_; ++n) {
+                    if (nodes_[n].sleepers.load(std::memory_order_relaxed) == 0)
+                        continue;
+                    std::lock_guard<std::mutex> lc{ nodes_[n].mutex };
+                    nodes_[n].cv.notify_all();
+                }
+            }
+            else if (spinning_count() == 0) {
+                maybe_grow(worker_node_[current_.index], queues_[current_.index].deque.size());
+            }
+            return;
+        }
+
+        std::size_t home = home_node();
+        node_queue& node = nodes_[home];
+        std::size_t idle, depth;
+        {
+            std::lock_guard<std::mutex> lc{ node.mutex };
+            for (Task& task : tasks)
+                node.tasks.push(std::move(task), {});
+            idle = node.sleepers.load(std::memory_order_relaxed) + node.spinning.load(std::memory_order_relaxed);
+            depth = node.tasks.size();
+        }
+        note_queue_depth(depth);
+        if (tasks.size() == 1)
+            node.cv.notify_one();
+        else
+            node.cv.notify_all();
+        if (idle < tasks.size() && !wake_other_node(home))
+            maybe_grow(home, depth);
+    }
+
+    void enqueue(Task&& task, const task_options& options = {}) {
+        if (mode_ == mode::work_stealing && current_.pool == this && options.is_default()) {
+            // 工作线程自己提交的任务放进自己的队列，最可能趁热执行
+            worker_queue& local = queues_[current_.index];
+            local.deque.push(acquire_node(std::move(task), clock::now()));
+            note_queue_depth(local.deque.size());
+            wake_one_if_sleeping();
+            return;
+        }
+
+        std::size_t home = home_node();
+        node_queue& node = nodes_[home];
+        bool spinning, sleeping;
+        std::size_t depth;
+        {
+            std::lock_guard<std::mutex> lc{ node.mutex };
+            node.tasks.push(std::move(task), options);
+            depth = node.tasks.size();
+            // 自旋的线程会自己发现新任务（它停止自旋后还会持锁再检查一次），积压不超过自旋线程数时
+            // 不必付出唤醒的系统调用
+            spinning = node.spinning.load(std::memory_order_relaxed) >= depth;
+            sleeping = node.sleepers.load(std::memory_order_relaxed) != 0;
+        }
+        note_queue_depth(depth);
+        if (spinning)
+            return;
+        if (sleeping)
+            node.cv.notify_one();
+        else if (!wake_other_node(home))
+            maybe_grow(home, depth);
+    }
+
+    // 节点 busy 上的线程都在忙：找一个有空闲线程的节点，请它的一个线程过来取任务。
+    // 只是不加锁地看一眼，刚好错过时任务也会由本节点的线程稍后执行。找到了返回 true。
+    bool wake_other_node(std::size_t busy) {
+        for (std::size_t k = 1; k < num_nodes_; ++k) {
+            node_queue& node = nodes_[(busy + k) % num_nodes_];
+            if (node.sleepers.load(std::memory_order_relaxed) == 0)
+                continue;
+            {
+                std::lock_guard<std::mutex> lc{ node.mutex };
+                if (node.spills >= node.sleepers.load(std::memory_order_relaxed))
+                    continue;
+                ++node.spills;
+            }
+            node.cv.notify_one();
+            return true;
+        }
+        return false;
+    }
+
+    // 当前线程属于哪个线程池的第几个工作线程（线程局部变量零初始化）
+    struct worker_context {
+        ThreadPool*       pool;
+        std::size_t       index;
+        clock::time_point last_finished; // 上一个任务结束的时刻，找不到任务闲下来时清零
+    };
+    inline static thread_local worker_context current_;
+
+    void enter_worker(std::size_t index) {
+        current_ = { this, index, {} };
+        metrics_[index].alive_since.store(clock::now().time_since_epoch() / std::chrono::nanoseconds{ 1 }, std::memory_order_relaxed);
+        if (!worker_cpus_.empty())
+            pin_current_thread(worker_cpus_[index]);
+    }
+
+    void worker_loop(std::size_t index) {
+        enter_worker(index);
+        node_queue& home = nodes_[worker_node_[index]];
+        std::minstd_rand rng{ static_cast<unsigned>(index + 1) };
+        while (!stop_) {
+            if (run_any(index, rng))
+                continue;
+            current_.last_finished = {};
+            if (spin_for_work(home))
+                continue;
+            if (!park(home, index))
+                break; // 空闲太久，线程池收缩
+        }
+        slot_metrics& m = metrics_[index];
+        std::int64_t now = clock::now().time_since_epoch() / std::chrono::nanoseconds{ 1 };
+        m.alive_ns.fetch_add(now - m.alive_since.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+        current_ = { nullptr, 0, {} };
+    }
+
+    bool run_any(std::size_t index, std::minstd_rand& rng) {
+        return mode_ == mode::work_stealing ? run_one(index, rng) : run_global();
+    }
+
+    // 不加锁地看一眼有没有任务，自旋时先看这个，免得反复去抢队列的锁
+    bool work_visible() const noexcept {
+        for (std::size_t n = 0; n < num_nodes_; ++n) {
+            if (!nodes_[n].tasks.empty())
+                return true;
+        }
+        if (mode_ == mode::work_stealing) {
+            for (std::size_t i = 0; i < num_queues_; ++i) {
+                if (!queues_[i].deque.empty())
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    std::size_t spinning_count() const noexcept {
+        std::size_t count = 0;
+        for (std::size_t n = 0; n < num_nodes_; ++n)
+            count += nodes_[n].spinning.load(std::memory_order_relaxed);
+        return count;
+    }
+
+    // 没活干后先自旋 spin_time：突发的任务往往前后脚到达，这样省掉一次 futex 睡眠和唤醒。
+    // 每隔几轮让出一次时间片，和提交者挤在同一个核上时不至于把它饿着。
+    bool spin_for_work(node_queue& home) {
+        if (elastic_.spin_time <= clock::duration::zero())
+            return false;
+        home.spinning.fetch_add(1);
+        auto deadline = clock::now() + elastic_.spin_time;
+        bool found = false;
+        for (unsigned round = 0; !stop_; ++round) {
+            if (work_visible()) { // 先退出自旋再执行，执行期间入队的任务照常唤醒别的线程
+                found = true;
+                break;
+            }
+            if (clock::now() >= deadline)
+                break;
+            if (round % 4 == 3) {
+                std::this_thread::yield();
+            }
+            else {
+                for (int i = 0; i < 16; ++i)
+                    cpu_relax();
+            }
+        }
+        home.spinning.fetch_sub(1); // seq_cst，与 wake_one_if_sleeping 中的 fence 配对
+        return found;
+    }
+
+    // 在本节点的条件变量上睡眠。能收缩的线程池里睡满 idle_timeout 还没活干、线程数又多于
+    // min_threads 时返回 false，线程随后退出。退出的决定在持锁、确认没有任务时做出，
+    // 所以不会带走已经发给它的唤醒。
+    bool park(node_queue& home, std::size_t index) {
+        auto ready = [&] {
+            return stop_ || !home.tasks.empty() || home.spills != 0 || (mode_ == mode::work_stealing && has_stealable());
+        };
+        std::unique_lock<std::mutex> lock{ home.mutex };
+        if (mode_ == mode::work_stealing)
+            sleepers_.fetch_add(1);
+        home.sleepers.fetch_add(1, std::memory_order_relaxed);
+        bool retire = false;
+        if (elastic_.max_threads > elastic_.min_threads)
+            retire = !home.cv.wait_for(lock, elastic_.idle_timeout, ready) && try_retire(index);
+        else
+            home.cv.wait(lock, ready);
+        home.sleepers.fetch_sub(1, std::memory_order_relaxed);
+        if (mode_ == mode::work_stealing)
+            sleepers_.fetch_sub(1);
+        if (home.spills != 0)
+            --home.spills; // 被别的节点叫醒，下一轮 run_global 会去那里取
+        return !retire;
+    }
+
+    bool try_retire(std::size_t index) {
+        std::lock_guard<std::mutex> lc{ grow_mutex_ };
+        if (stop_ || num_thread_.load(std::memory_order_relaxed) <= elastic_.min_threads)
+            return false;
+        num_thread_.fetch_sub(1, std::memory_order_relaxed);
+        retired_.push_back(index); // std::thread 对象留给下一次在这个槽位上启动线程时 join
+        return true;
+    }
+
+    // 没有空闲线程可以唤醒时调用：积压够多就在 node 上加一个线程。同一时刻只有一个线程在扩容。
+    void maybe_grow(std::size_t node, std::size_t depth) noexcept {
+        if (depth < elastic_.grow_queue_depth || num_thread_.load(std::memory_order_relaxed) >= elastic_.max_threads)
+            return;
+        if (growing_.exchange(true, std::memory_order_acquire))
+            return;
+        try {
+            std::lock_guard<std::mutex> lc{ grow_mutex_ };
+            if (!stop_ && num_thread_.load(std::memory_order_relaxed) < elastic_.max_threads)
+                spawn_worker(free_slot(node));
+        }
+        catch (...) {
+            // 创建线程失败（资源不足）就维持现有的线程数，任务已经在队列里了
+        }
+        growing_.store(false, std::memory_order_release);
+    }
+
+    // 持有 grow_mutex_ 时调用：优先选 node 上的空槽位
+    std::size_t free_slot(std::size_t node) const noexcept {
+        std::size_t fallback = pool_.size();
+        for (std::size_t i = 0; i < pool_.size(); ++i) {
+            bool free = !pool_[i].joinable() || std::find(retired_.begin(), retired_.end(), i) != retired_.end();
+            if (!free)
+                continue;
+            if (worker_node_[i] == node)
+                return i;
+            if (fallback == pool_.size())
+                fallback = i;
+        }
+        return fallback;
+    }
+
+    // 持有 grow_mutex_ 时调用
+    void spawn_worker(std::size_t slot) {
+        if (auto it = std::find(retired_.begin(), retired_.end(), slot); it != retired_.end()) {
+            pool_[slot].join(); // 已经决定退出，很快就会结束
+            retired_.erase(it);
+        }
+        pool_[slot] = std::thread{ [this, slot] { worker_loop(slot); } };
+        num_thread_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // 依次尝试：自己的队列（LIFO）、全局注入队列、随机挑选的其它线程（FIFO）。
+    // 全局队列里有高优先级或截止时间临近的任务时先去取它，不让它排在本地任务后面；此外每执行 61 个任务
+    // 也先看一次全局队列，否则不断给自己提交任务的线程会让外部提交的任务一直饿着。
+    bool run_one(std::size_t index, std::minstd_rand& rng) {
+        if (has_urgent() && run_global())
+            return true;
+        if (++queues_[index].ticks % 61 == 0 && run_global_batch())
+            return true;
+
+        if (auto task = queues_[index].deque.pop()) {
+            run_node(*task);
+            return true;
+        }
+
+        if (run_global_batch())
+            return true;
+
+        // 分成 NUMA 子线程池时先偷同一节点的线程，数据更可能还在共享的缓存里
+        for (bool same_node : { num_nodes_ > 1, false }) {
+            for (std::size_t attempt = 0; attempt < num_queues_; ++attempt) {
+                std::size_t victim = rng() % num_queues_;
+                if (victim == index || (same_node && worker_node_[victim] != worker_node_[index]))
+                    continue;
+                if (auto task = queues_[victim].deque.steal()) {
+                    metrics_[index].steals.fetch_add(1, std::memory_order_relaxed);
+                    run_node(*task);
+                    return true;
+                }
+            }
+            if (!same_node)
+                break;
+        }
+        return false;
+    }
+
+    // 从全局队列按顺序取一批（平均分给各线程的份额，最多 32 个）依次执行。
+    // 一次只取一个的话，隔 61 个任务才来一次的取法跟不上外部提交的速度；而放进自己的双端队列
+    // 又会被压在后来不断产生的本地任务底下（LIFO），在所有线程都很忙时一直得不到执行。
+    bool run_global_batch() {
+        constexpr std::size_t max_batch = 32;
+        std::array<queued_task, max_batch> batch;
+        std::size_t count = 0;
+        node_queue* node = pick_node();
+        if (node == nullptr)
+            return false;
+        {
+            std::lock_guard<std::mutex> lc{ node->mutex };
+            std::size_t share = node->tasks.size() / std::max<std::size_t>(1, num_thread_.load(std::memory_order_relaxed) / num_nodes_) + 1;
+            count = std::min(share, std::min(node->tasks.size(), max_batch));
+            for (std::size_t i = 0; i < count; ++i)
+                batch[i] = node->tasks.pop();
+        }
+        if (count != 0)
+            grow_if_backlogged(*node);
+        for (std::size_t i = 0; i < count; ++i) {
+            while (i > 0 && has_urgent() && run_global()) {} // 批中途来了紧急任务，先执行它
+            run_task(batch[i].task, batch[i].enqueued);
+        }
+        return count != 0;
+    }
+
+    bool has_stealable() const noexcept {
+        std::atomic_thread_fence(std::memory_order_seq_cst); // 与 wake_one_if_sleeping 中的 fence 配对
+        for (std::size_t i = 0; i < num_queues_; ++i) {
+            if (!queues_[i].deque.empty())
+                return true;
+        }
+        return false;
+    }
+
+    // 入队（bottom 的写入）和检查 sleepers_ 之间用 seq_cst fence 隔开：
+    // 要么这里看到有线程准备睡眠，要么那个线程在 has_stealable 中看到新任务。
+    void wake_one_if_sleeping() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::size_t depth = queues_[current_.index].deque.size();
+        if (spinning_count() >= depth)
+            return; // 自旋的线程会看到它（spin_for_work 退出时的 seq_cst 与这里的 fence 配对）
+        if (sleepers_.load(std::memory_order_relaxed) == 0) {
+            maybe_grow(worker_node_[current_.index], depth);
+            return;
+        }
+        // 睡眠者都会检查所有双端队列，叫醒哪个节点的都行，优先本节点
+        std::size_t home = home_node();
+        for (std::size_t k = 0; k < num_nodes_; ++k) {
+            node_queue& node = nodes_[(home + k) % num_nodes_];
+            if (k + 1 < num_nodes_ && node.sleepers.load(std::memory_order_relaxed) == 0)
+                continue;
+            std::lock_guard<std::mutex> lc{ node.mutex }; // 等睡眠者真正进入 wait
+            node.cv.notify_one();
+            return;
+        }
+    }
+
+    // 决定每个工作线程属于哪个节点、绑定到哪些 CPU
+    void place_workers(placement p) {
+        std::size_t count = elastic_.max_threads; // 每个线程槽位的位置是固定的
+        const cpu_topology& topology = cpu_topology::get();
+        worker_node_.assign(count, 0);
+        if (p == placement::compact || p == placement::scatter) {
+            std::vector<unsigned> order = p == placement::compact ? topology.compact_order() : topology.scatter_order();
+            for (std::size_t i = 0; i < count; ++i)
+                worker_cpus_.push_back({ order[i % order.size()] });
+        }
+        else if (p == placement::numa_nodes) {
+            num_nodes_ = std::clamp<std::size_t>(topology.node_count(), 1, std::max<std::size_t>(1, count));
+            for (std::size_t i = 0; i < count; ++i) {
+                worker_node_[i] = i % num_nodes_;
+                std::vector<unsigned> cpus;
+                for (std::size_t node = worker_node_[i]; node < topology.node_count(); node += num_nodes_) {
+                    auto ids = topology.node_cpus(node);
+                    cpus.insert(cpus.end(), ids.begin(), ids.end());
+                }
+                worker_cpus_.push_back(std::move(cpus));
+            }
+            for (const auto& c : topology.cpus()) {
+                if (c.id >= cpu_node_.size())
+                    cpu_node_.resize(c.id + 1, 0);
+                cpu_node_[c.id] = c.node % num_nodes_;
+            }
+        }
+        nodes_ = std::make_unique<node_queue[]>(num_nodes_);
+    }
+
+    std::atomic<bool>        stop_;
+    std::atomic<std::size_t> num_thread_; // 当前活着的工作线程数
+    std::vector<std::thread> pool_;       // 每个线程槽位一个，长度为 max_threads
+
+    std::unique_ptr<node_queue[]>      nodes_;
+    std::size_t                        num_nodes_ = 1;
+    std::vector<std::size_t>           worker_node_; // 工作线程 -> 节点
+    std::vector<std::vector<unsigned>> worker_cpus_; // 工作线程 -> 绑定的 CPU，空表示不绑定
+    std::vector<std::size_t>           cpu_node_;    // CPU 编号 -> 节点，给外部提交者用
+
+    mode                            mode_;
+    std::unique_ptr<worker_queue[]> queues_;
+    std::size_t                     num_queues_ = 0;
+    std::atomic<std::size_t>        sleepers_{ 0 };
+
+    elastic_options          elastic_;
+    std::mutex               grow_mutex_; // 保护 pool_ 和 retired_
+    std::vector<std::size_t> retired_;    // 已经决定退出、还没被 join 的槽位
+    std::atomic<bool>        growing_{ false };
+
+    std::unique_ptr<slot_metrics[]>       metrics_; // max_threads + 1 份
+    alignas(64) std::atomic<std::size_t>  peak_depth_{ 0 };
+};
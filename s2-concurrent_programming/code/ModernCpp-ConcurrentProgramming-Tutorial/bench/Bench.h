@@ -0,0 +1,92 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// bench 目录下各个基准测试共用的小工具
+
+using bench_clock = std::chrono::steady_clock;
+
+// 在包含 Bench.h 之前定义 BENCH_COUNT_ALLOCATIONS，就替换全局 operator new 来统计堆分配次数，
+// 用 bench_allocations 读取。替换函数不能是 inline 的，一个可执行文件里只能有一个源文件这样做。
+#if defined(BENCH_COUNT_ALLOCATIONS)
+inline std::atomic<long> bench_allocations{ 0 };
+
+void* operator new(std::size_t size) {
+    bench_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size))
+        return p;
+    throw std::bad_alloc{};
+}
+
+// 上面的 operator new 就是 malloc，GCC 看不出来，会把这里的 free 当成和 new 不配对
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+// "1,2,4,8" 这样的逗号分隔的数字列表，空的时候返回 fallback
+inline std::vector<std::size_t> bench_parse_list(std::string_view arg, std::vector<std::size_t> fallback) {
+    std::vector<std::size_t> values;
+    while (!arg.empty()) {
+        auto pos = arg.find(',');
+        values.push_back(std::strtoul(std::string{ arg.substr(0, pos) }.c_str(), nullptr, 10));
+        arg = pos == arg.npos ? std::string_view{} : arg.substr(pos + 1);
+    }
+    return values.empty() ? fallback : values;
+}
+
+// 命令行第一个参数可以指定线程数列表，例如 "1,2,4,8"，默认 1 到 64 的 2 的幂
+inline std::vector<std::size_t> bench_thread_counts(int argc, char* argv[]) {
+    std::vector<std::size_t> counts = bench_parse_list(argc > 1 ? argv[1] : "", {});
+    std::erase(counts, 0);
+    if (counts.empty())
+        counts = { 1, 2, 4, 8, 16, 32, 64 };
+    return counts;
+}
+
+template<typename F>
+double bench_seconds(F&& f) {
+    auto start = bench_clock::now();
+    f();
+    return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+// 模拟一小段计算，防止被优化掉
+inline void bench_spin(unsigned iterations) {
+    for (unsigned i = 0; i < iterations; ++i) {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" ::: "memory");
+#else
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+    }
+}
+
+// 计数器归零时唤醒等待者，用来等待一批“发射后不管”的任务全部完成
+class bench_countdown {
+public:
+    explicit bench_countdown(long count) : count_{ count } {}
+    void count_down() {
+        if (count_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            count_.notify_all();
+    }
+    void wait() {
+        for (long v = count_.load(std::memory_order_acquire); v != 0; v = count_.load(std::memory_order_acquire))
+            count_.wait(v);
+    }
+private:
+    std::atomic<long> count_;
+};
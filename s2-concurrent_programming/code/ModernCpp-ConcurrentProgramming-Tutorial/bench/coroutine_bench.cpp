@@ -0,0 +1,113 @@
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <format>
+#include <thread>
+#include <vector>
+#include "../ThreadPool.h"
+#include "../Coroutine.h"
+#define BENCH_COUNT_ALLOCATIONS
+#include "Bench.h"
+
+// 异步流水线：num_pipelines 条流水线同时运行，每条依次经过 num_stages 个阶段，
+// 每个阶段都是线程池上的一个小任务，下一阶段依赖上一阶段的结果。
+//   submit+get : 每条流水线一个驱动线程，每个阶段 submit 后阻塞 get
+//   then       : 主线程把整条链用 then 串起来，最后只等末端的 future
+//   coroutine  : 每个阶段是一个 task<int>，co_await pool.schedule() 切到工作线程，
+//                驱动线程只在最外层 sync_wait 一次
+// 表中是每个阶段的平均耗时（微秒）和堆分配次数。用法：coroutine_bench [线程数列表]
+
+constexpr int num_pipelines = 16;
+constexpr int num_stages    = 5000;
+
+int step(int x) {
+    bench_spin(200);
+    return x * 7 % 1000003 + 1;
+}
+
+int expected_result() {
+    int x = 0;
+    for (int i = 0; i < num_stages; ++i)
+        x = step(x);
+    return x;
+}
+
+struct result {
+    double us_per_stage;
+    double allocations_per_stage;
+};
+
+template<typename F>
+result measure(F&& run) {
+    run(); // 预热
+    long before = bench_allocations.load();
+    double seconds = bench_seconds(run);
+    constexpr double stages = double(num_pipelines) * num_stages;
+    return { seconds * 1e6 / stages, double(bench_allocations.load() - before) / stages };
+}
+
+void check(int value) {
+    static const int expected = expected_result();
+    if (value != expected) {
+        std::cerr << "wrong result\n";
+        std::abort();
+    }
+}
+
+task<int> stage(ThreadPool& pool, int x) {
+    co_await pool.schedule();
+    co_return step(x);
+}
+
+task<int> pipeline(ThreadPool& pool) {
+    int x = 0;
+    for (int i = 0; i < num_stages; ++i)
+        x = co_await stage(pool, x);
+    co_return x;
+}
+
+int main(int argc, char* argv[]) {
+    std::cout << std::format("{:>8} {:>14} {:>12} {:>12} {:>12} {:>12} {:>12} {:>12}\n", "threads", "mode",
+        "get(us)", "get(alloc)", "then(us)", "then(alloc)", "coro(us)", "coro(alloc)");
+    for (std::size_t threads : bench_thread_counts(argc, argv)) {
+        for (auto mode : { ThreadPool::mode::fifo, ThreadPool::mode::work_stealing }) {
+            ThreadPool pool{ threads, mode };
+
+            auto blocking = measure([&] {
+                std::vector<std::jthread> drivers;
+                for (int p = 0; p < num_pipelines; ++p) {
+                    drivers.emplace_back([&] {
+                        int x = 0;
+                        for (int i = 0; i < num_stages; ++i)
+                            x = pool.submit(step, x).get();
+                        check(x);
+                    });
+                }
+            });
+
+            auto chained = measure([&] {
+                std::vector<task_future<int>> tails;
+                for (int p = 0; p < num_pipelines; ++p) {
+                    auto future = pool.submit([] { return 0; });
+                    for (int i = 0; i < num_stages; ++i)
+                        future = future.then(step);
+                    tails.push_back(std::move(future));
+                }
+                for (auto& future : tails)
+                    check(future.get());
+            });
+
+            auto coroutine = measure([&] {
+                std::vector<std::jthread> drivers;
+                for (int p = 0; p < num_pipelines; ++p)
+                    drivers.emplace_back([&] { check(sync_wait(pipeline(pool))); });
+            });
+
+            std::cout << std::format("{:>8} {:>14} {:>12.2f} {:>12.2f} {:>12.2f} {:>12.2f} {:>12.2f} {:>12.2f}\n", threads,
+                mode == ThreadPool::mode::fifo ? "fifo" : "work_stealing",
+                blocking.us_per_stage, blocking.allocations_per_stage,
+                chained.us_per_stage, chained.allocations_per_stage,
+                coroutine.us_per_stage, coroutine.allocations_per_stage);
+        }
+    }
+}
@@ -0,0 +1,71 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <format>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "../ShardedCounter.h"
+#include "Bench.h"
+
+// 热点计数器：N 个线程在 duration 内不停地加一，表中是所有线程合计每秒的加法次数（百万）。
+//   atomic     : 一个全局 std::atomic<std::uint64_t>，fetch_add
+//   unpadded   : 每个线程一个 atomic，但紧挨着放在一个数组里，相邻线程伪共享
+//   sharded    : sharded_counter，每个线程一个对齐的槽位，没有读-改-写
+//   per_cpu    : per_cpu_counter，sched_getcpu 选槽位再 fetch_add
+// 最后一列是 sharded_counter::read 一次的耗时（纳秒）。用法：counter_bench [线程数列表]
+
+using namespace std::chrono_literals;
+
+constexpr auto duration = 200ms;
+
+template<typename Add>
+double run(std::size_t threads, Add add) {
+    std::atomic<bool> stop{ false };
+    std::atomic<std::uint64_t> total{ 0 };
+    double seconds = bench_seconds([&] {
+        std::vector<std::jthread> workers;
+        for (std::size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                std::uint64_t count = 0;
+                for (; !stop.load(std::memory_order_relaxed); ++count)
+                    add(t);
+                total.fetch_add(count);
+            });
+        }
+        std::this_thread::sleep_for(duration);
+        stop = true;
+    });
+    return static_cast<double>(total.load()) / seconds / 1e6;
+}
+
+int main(int argc, char* argv[]) {
+    std::cout << std::format("{:>8} {:>10} {:>10} {:>10} {:>10} {:>10}\n",
+        "threads", "atomic", "unpadded", "sharded", "per_cpu", "read ns");
+    for (std::size_t threads : bench_thread_counts(argc, argv)) {
+        std::atomic<std::uint64_t> shared{ 0 };
+        double a = run(threads, [&](std::size_t) { shared.fetch_add(1, std::memory_order_relaxed); });
+
+        auto adjacent = std::make_unique<std::atomic<std::uint64_t>[]>(threads);
+        double b = run(threads, [&](std::size_t t) { adjacent[t].fetch_add(1, std::memory_order_relaxed); });
+
+        sharded_counter sharded;
+        double c = run(threads, [&](std::size_t) { sharded.add(); });
+
+        per_cpu_counter per_cpu;
+        double d = run(threads, [&](std::size_t) { per_cpu.add(); });
+
+        constexpr int reads = 100000;
+        std::uint64_t sum = 0;
+        double read_seconds = bench_seconds([&] {
+            for (int i = 0; i < reads; ++i)
+                sum += sharded.read();
+        });
+        if (sum == 0 || per_cpu.read() == 0)
+            std::abort();
+
+        std::cout << std::format("{:>8} {:>10.2f} {:>10.2f} {:>10.2f} {:>10.2f} {:>10.1f}\n",
+            threads, a, b, c, d, read_seconds / reads * 1e9);
+    }
+}
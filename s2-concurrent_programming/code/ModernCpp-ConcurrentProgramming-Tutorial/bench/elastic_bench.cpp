@@ -0,0 +1,68 @@
+#include <algorithm>
+#include <iostream>
+#include <format>
+#include <thread>
+#include <vector>
+#include "../ThreadPool.h"
+#include "Bench.h"
+
+// 突发负载：每隔 burst_gap 一次提交 burst_size 个小任务，测从提交第一个到全部完成的时间。
+//   park      : 固定线程数，没活干立即睡眠（每次突发都要付出 futex 唤醒）
+//   spin      : 固定线程数，先自旋 50us 再睡眠
+//   elastic   : 1 到 N 个线程按积压伸缩，也先自旋
+// idle 列是突发之间空闲时的平均线程数。用法：elastic_bench [线程数列表]
+
+using namespace std::chrono_literals;
+
+constexpr int  bursts     = 400;
+constexpr int  burst_size = 64;
+constexpr auto burst_gap  = 2ms;
+
+struct result {
+    double p50, p99;  // 微秒
+    double idle_threads;
+};
+
+result run(ThreadPool& pool) {
+    std::vector<double> latency;
+    double idle_threads = 0;
+    for (int b = 0; b < bursts; ++b) {
+        std::this_thread::sleep_for(burst_gap);
+        idle_threads += pool.thread_count();
+        bench_countdown done{ burst_size };
+        auto start = bench_clock::now();
+        for (int i = 0; i < burst_size; ++i) {
+            pool.post([&done] {
+                bench_spin(2000);
+                done.count_down();
+            });
+        }
+        done.wait();
+        latency.push_back(std::chrono::duration<double, std::micro>(bench_clock::now() - start).count());
+    }
+    std::sort(latency.begin(), latency.end());
+    return { latency[bursts / 2], latency[bursts * 99 / 100], idle_threads / bursts };
+}
+
+int main(int argc, char* argv[]) {
+    std::cout << std::format("{:>8} {:>14} {:>10} {:>18} {:>18} {:>18}\n", "threads", "mode", "variant", "p50(us)", "p99(us)", "idle threads");
+    for (std::size_t threads : bench_thread_counts(argc, argv)) {
+        for (auto mode : { ThreadPool::mode::fifo, ThreadPool::mode::work_stealing }) {
+            struct variant {
+                const char*                 name;
+                ThreadPool::elastic_options options;
+            };
+            ThreadPool::elastic_options park{ threads, threads };
+            park.spin_time = {};
+            ThreadPool::elastic_options spin{ threads, threads };
+            ThreadPool::elastic_options elastic{ 1, threads };
+            elastic.idle_timeout = 1ms; // 比突发间隔短，演示收缩
+            for (const auto& [name, options] : { variant{ "park", park }, variant{ "spin", spin }, variant{ "elastic", elastic } }) {
+                ThreadPool pool{ options, mode };
+                auto r = run(pool);
+                std::cout << std::format("{:>8} {:>14} {:>10} {:>18.1f} {:>18.1f} {:>18.2f}\n", threads,
+                    mode == ThreadPool::mode::fifo ? "fifo" : "work_stealing", name, r.p50, r.p99, r.idle_threads);
+            }
+        }
+    }
+}
@@ -0,0 +1,111 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <format>
+#include <map>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../ConcurrentHashMap.h"
+#include "Bench.h"
+
+// 读写混合：N 个线程在 num_keys 个字符串键上随机查找或写入，写的比例分别是 5% 和 50%。
+//   map+shared_mutex : 一把读写锁保护 std::map（Settings 的做法），查找返回副本
+//   hash_map find    : concurrent_hash_map，查找返回副本
+//   hash_map visit   : concurrent_hash_map，在锁内读取，不复制
+// 表中是所有线程合计每秒的操作数（百万）。用法：hash_map_bench [线程数列表]
+
+using namespace std::chrono_literals;
+
+constexpr int  num_keys = 1024;
+constexpr auto duration = 200ms;
+
+class locked_map {
+public:
+    void set(const std::string& key, const std::string& value) {
+        std::lock_guard<std::shared_mutex> lock{ mutex_ };
+        data_[key] = value;
+    }
+    std::string get(const std::string& key) const {
+        std::shared_lock<std::shared_mutex> lock{ mutex_ };
+        auto it = data_.find(key);
+        return it != data_.end() ? it->second : "";
+    }
+private:
+    std::map<std::string, std::string> data_;
+    mutable std::shared_mutex          mutex_;
+};
+
+const std::vector<std::string>& keys() {
+    static const std::vector<std::string> instance = [] {
+        std::vector<std::string> k;
+        for (int i = 0; i < num_keys; ++i)
+            k.push_back(std::format("user/{}/profile", i * 7919));
+        return k;
+    }();
+    return instance;
+}
+
+// write(key, value) 和 read(key)（返回读到的长度）
+template<typename Write, typename Read>
+double run(std::size_t threads, unsigned write_percent, Write write, Read read) {
+    for (const auto& key : keys())
+        write(key, "initial value of " + key);
+    std::atomic<bool> stop{ false };
+    std::atomic<std::uint64_t> total{ 0 };
+    double seconds = bench_seconds([&] {
+        std::vector<std::jthread> workers;
+        for (std::size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                std::minstd_rand rng{ static_cast<unsigned>(t + 1) };
+                const std::string value = std::format("value written by thread {}", t);
+                std::uint64_t count = 0, length = 0;
+                for (; !stop.load(std::memory_order_relaxed); ++count) {
+                    const std::string& key = keys()[rng() % num_keys];
+                    if (rng() % 100 < write_percent)
+                        write(key, value);
+                    else
+                        length += read(key);
+                }
+                if (length == 0 && write_percent < 100)
+                    std::abort();
+                total.fetch_add(count);
+            });
+        }
+        std::this_thread::sleep_for(duration);
+        stop = true;
+    });
+    return static_cast<double>(total.load()) / seconds / 1e6;
+}
+
+int main(int argc, char* argv[]) {
+    std::cout << std::format("{:>8} {:>8} {:>18} {:>18} {:>18}\n", "threads", "writes", "map+shared_mutex", "hash_map find", "hash_map visit");
+    for (std::size_t threads : bench_thread_counts(argc, argv)) {
+        for (unsigned write_percent : { 5u, 50u }) {
+            locked_map locked;
+            double a = run(threads, write_percent,
+                [&](const std::string& k, const std::string& v) { locked.set(k, v); },
+                [&](const std::string& k) { return locked.get(k).size(); });
+
+            concurrent_hash_map<std::string, std::string> copying;
+            double b = run(threads, write_percent,
+                [&](const std::string& k, const std::string& v) { copying.insert_or_assign(k, v); },
+                [&](const std::string& k) { return copying.find(k).value_or("").size(); });
+
+            concurrent_hash_map<std::string, std::string> visiting;
+            double c = run(threads, write_percent,
+                [&](const std::string& k, const std::string& v) { visiting.insert_or_assign(k, v); },
+                [&](const std::string& k) {
+                    std::size_t n = 0;
+                    visiting.visit(k, [&](const std::string& v) { n = v.size(); });
+                    return n;
+                });
+
+            std::cout << std::format("{:>8} {:>7}% {:>18.2f} {:>18.2f} {:>18.2f}\n", threads, write_percent, a, b, c);
+        }
+    }
+}
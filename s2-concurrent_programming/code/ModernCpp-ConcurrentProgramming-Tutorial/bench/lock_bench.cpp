@@ -0,0 +1,81 @@
+#include <ctime>
+#include <cstdlib>
+#include <iostream>
+#include <format>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../SpinLock.h"
+#include "Bench.h"
+
+// 锁竞争：N 个线程反复加锁、在临界区里做 cs 次空循环、解锁，再在锁外做 outside 次空循环。
+//   tas        : 改进前的 spinlock_mutex，不停地 test_and_set
+//   spinlock   : TTAS + 指数退避
+//   adaptive   : 先自旋再睡眠的 adaptive_mutex
+//   std::mutex
+// 左边是吞吐量（百万次加锁/秒），右边是每次加锁消耗的 CPU 时间（微秒，所有线程合计），
+// 线程多于核数时自旋锁的 CPU 时间会急剧上升。用法：lock_bench [线程数列表]
+
+constexpr long     total_ops  = 400'000;
+constexpr unsigned outside    = 200;
+constexpr unsigned cs_lengths[] = { 0, 100, 1000 };
+
+class tas_spinlock {
+public:
+    void lock() noexcept {
+        while (flag_.test_and_set(std::memory_order_acquire));
+    }
+    void unlock() noexcept {
+        flag_.clear(std::memory_order_release);
+    }
+private:
+    std::atomic_flag flag_{};
+};
+
+struct result {
+    double mops;
+    double cpu_us_per_op;
+};
+
+template<typename Mutex>
+result run(std::size_t threads, unsigned cs) {
+    Mutex m;
+    long counter = 0;
+    long per_thread = total_ops / static_cast<long>(threads);
+    std::clock_t cpu_start = std::clock();
+    double seconds = bench_seconds([&] {
+        std::vector<std::jthread> workers;
+        for (std::size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&] {
+                for (long i = 0; i < per_thread; ++i) {
+                    {
+                        std::lock_guard<Mutex> lc{ m };
+                        bench_spin(cs);
+                        ++counter;
+                    }
+                    bench_spin(outside);
+                }
+            });
+        }
+    });
+    double cpu_seconds = static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+    if (counter != per_thread * static_cast<long>(threads)) {
+        std::cerr << "lost update\n";
+        std::abort();
+    }
+    return { counter / seconds / 1e6, cpu_seconds * 1e6 / counter };
+}
+
+int main(int argc, char* argv[]) {
+    std::cout << std::format("{:>8} {:>6} | {:>10} {:>10} {:>10} {:>10} | {:>10} {:>10} {:>10} {:>10}\n", "threads", "cs",
+        "tas", "spinlock", "adaptive", "std::mutex", "tas", "spinlock", "adaptive", "std::mutex");
+    for (std::size_t threads : bench_thread_counts(argc, argv)) {
+        for (unsigned cs : cs_lengths) {
+            result r[] = { run<tas_spinlock>(threads, cs), run<spinlock_mutex>(threads, cs),
+                           run<adaptive_mutex>(threads, cs), run<std::mutex>(threads, cs) };
+            std::cout << std::format("{:>8} {:>6} | {:>10.3f} {:>10.3f} {:>10.3f} {:>10.3f} | {:>10.3f} {:>10.3f} {:>10.3f} {:>10.3f}\n",
+                threads, cs, r[0].mops, r[1].mops, r[2].mops, r[3].mops,
+                r[0].cpu_us_per_op, r[1].cpu_us_per_op, r[2].cpu_us_per_op, r[3].cpu_us_per_op);
+        }
+    }
+}
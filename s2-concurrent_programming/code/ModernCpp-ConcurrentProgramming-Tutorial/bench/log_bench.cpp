@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <format>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <spdlog/async.h>
+#include <spdlog/sinks/basic_file_sink.h>
+#include "../AsyncLog.h"
+#include "Bench.h"
+
+// 打日志的调用线程要花多久：N 个线程各自连续写 count 条（一个整数、一个浮点数、一个字符串），
+// 写到临时目录下的同一个文件里，格式和 Log.h 的文件 sink 一样。
+//   sync         : spdlog 的同步 logger，调用线程里格式化并写文件（Log.h 默认的 LOG_INFO）
+//   spdlog async : spdlog::async_logger，调用线程格式化成字符串，再放进带锁的队列
+//   async_logger : AsyncLog.h，调用线程只复制参数（定义 LOG_ASYNC 时的 LOG_INFO）
+// 每 16 条抽一条单独计时，表中 p50、p99 是这些调用的纳秒数（含两次取时间的开销）；
+// drain 是从开始到最后一条写进文件并 flush 的总时间（毫秒）。
+// async_logger 每个线程的缓冲区默认 1 MiB，放不下一整批时调用线程要等后台线程腾出空间，p99 随之变大。
+// CPU 比线程少时，后台线程和调用线程抢同一个核，单次调用里可能夹着一次抢占。
+// 用法：log_bench [线程数列表] [每个线程的条数]
+
+constexpr const char* pattern = "[%Y-%m-%d %H:%M:%S] [%@] [%!] [thread %t] [%l] %v";
+
+struct result {
+    double p50_ns = 0;
+    double p99_ns = 0;
+    double drain_ms = 0;
+};
+
+// log(i, text) 写一条日志，finish() 等到所有日志写完
+template<typename Log, typename Finish>
+result run(std::size_t threads, std::size_t count, Log log, Finish finish) {
+    std::vector<std::vector<double>> samples(threads);
+    double seconds = bench_seconds([&] {
+        {
+            std::vector<std::jthread> workers;
+            for (std::size_t t = 0; t < threads; ++t) {
+                workers.emplace_back([&, t] {
+                    std::string text = "worker-" + std::to_string(t);
+                    samples[t].reserve(count / 16 + 1);
+                    for (std::size_t i = 0; i < count; ++i) {
+                        if (i % 16 != 0) {
+                            log(i, text);
+                            continue;
+                        }
+                        auto start = bench_clock::now();
+                        log(i, text);
+                        samples[t].push_back(std::chrono::duration<double, std::nano>(bench_clock::now() - start).count());
+                    }
+                });
+            }
+        }
+        finish();
+    });
+
+    std::vector<double> all;
+    for (auto& s : samples)
+        all.insert(all.end(), s.begin(), s.end());
+    std::sort(all.begin(), all.end());
+    return { all[all.size() / 2], all[all.size() * 99 / 100], seconds * 1e3 };
+}
+
+std::shared_ptr<spdlog::sinks::basic_file_sink_mt> make_sink(const std::string& path) {
+    auto sink = std::make_shared<spdlog::sinks::basic_file_sink_mt>(path, true);
+    sink->set_pattern(pattern);
+    return sink;
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t count = std::max<std::size_t>(argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 10000, 1);
+    std::string path = (std::filesystem::temp_directory_path() / "log_bench.txt").string();
+
+    std::cout << std::format("{:>8} | {:>26} | {:>26} | {:>26}\n", "", "sync", "spdlog async", "async_logger");
+    std::cout << std::format("{:>8} | {:>8} {:>8} {:>8} | {:>8} {:>8} {:>8} | {:>8} {:>8} {:>8}\n", "threads",
+        "p50", "p99", "drain", "p50", "p99", "drain", "p50", "p99", "drain");
+    for (std::size_t threads : bench_thread_counts(argc, argv)) {
+        auto sync = std::make_shared<spdlog::logger>("sync", make_sink(path));
+        result a = run(threads, count, [&](std::size_t i, const std::string& text) {
+            SPDLOG_LOGGER_INFO(sync, "request {} took {:.3f} ms from {}", i, i * 0.001, text);
+        }, [&] { sync->flush(); });
+
+        // 队列要装得下所有日志，否则测到的是队列满了之后的阻塞
+        auto pool = std::make_shared<spdlog::details::thread_pool>(threads * count, 1);
+        auto queued = std::make_shared<spdlog::async_logger>("queued", make_sink(path), pool, spdlog::async_overflow_policy::block);
+        result b = run(threads, count, [&](std::size_t i, const std::string& text) {
+            SPDLOG_LOGGER_INFO(queued, "request {} took {:.3f} ms from {}", i, i * 0.001, text);
+        }, [&] {
+            queued.reset(); // 析构时等线程池写完
+            pool.reset();
+        });
+
+        auto backend = std::make_shared<spdlog::logger>("backend", make_sink(path));
+        async_logger async{ backend };
+        static const async_log_site site{ spdlog::level::info, __FILE__, __LINE__, "main" };
+        result c = run(threads, count, [&](std::size_t i, const std::string& text) {
+            async.log(site, "request {} took {:.3f} ms from {}", i, i * 0.001, text);
+        }, [&] { async.flush(); });
+
+        std::cout << std::format("{:>8} | {:>8.0f} {:>8.0f} {:>8.1f} | {:>8.0f} {:>8.0f} {:>8.1f} | {:>8.0f} {:>8.0f} {:>8.1f}\n", threads,
+            a.p50_ns, a.p99_ns, a.drain_ms, b.p50_ns, b.p99_ns, b.drain_ms, c.p50_ns, c.p99_ns, c.drain_ms);
+    }
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,70 @@
+#include <chrono>
+#include <iostream>
+#include <format>
+#include <thread>
+#include <vector>
+#include "../ThreadPool.h"
+#include "Bench.h"
+
+// 线程池的运行统计：混合负载（大量很短的小任务，夹杂 1% 长 100 倍的大任务，每个任务执行时
+// 再提交一个子任务），每 100ms 取一次快照，按两次快照的差值输出这段时间的吞吐、排队和执行时间的
+// 分位数，最后输出各工作线程的利用率。导出到监控系统时也是这样用。
+// 用法：metrics_bench [线程数列表]
+
+using namespace std::chrono_literals;
+
+constexpr int  rounds          = 5;
+constexpr int  tasks_per_round = 5'000;
+constexpr auto round_gap       = 100ms;
+
+histogram_snapshot operator-(histogram_snapshot a, const histogram_snapshot& b) {
+    for (std::size_t i = 0; i < a.bucket_count; ++i)
+        a.buckets[i] -= b.buckets[i];
+    a.count -= b.count;
+    a.sum_ns -= b.sum_ns;
+    return a;
+}
+
+double us(std::chrono::nanoseconds d) {
+    return std::chrono::duration<double, std::micro>(d).count();
+}
+
+void run(ThreadPool& pool) {
+    bench_countdown done{ static_cast<long>(rounds) * tasks_per_round * 2 };
+    auto prev = pool.metrics();
+    for (int r = 0; r < rounds; ++r) {
+        for (int i = 0; i < tasks_per_round; ++i) {
+            pool.post([&pool, &done, i] {
+                bench_spin(i % 100 == 0 ? 200'000 : 2000);
+                pool.post([&done] { bench_spin(2000); done.count_down(); }); // 工作窃取模式下进本地队列
+                done.count_down();
+            });
+        }
+        std::this_thread::sleep_for(round_gap);
+        auto now = pool.metrics();
+        histogram_snapshot wait = now.wait - prev.wait, exec = now.exec - prev.exec;
+        std::cout << std::format("{:>6} {:>10} {:>8} {:>8} {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f} {:>10}\n", r,
+            now.tasks - prev.tasks, now.queue_depth, pool.reset_peak_queue_depth(),
+            us(wait.percentile(0.5)), us(wait.percentile(0.99)), us(exec.percentile(0.5)), us(exec.percentile(0.99)),
+            now.steals - prev.steals);
+        prev = now;
+    }
+    done.wait();
+    auto last = pool.metrics();
+    for (std::size_t i = 0; i < last.workers.size(); ++i) {
+        const auto& w = last.workers[i];
+        std::cout << std::format("    worker {:>3}: {:>8} tasks {:>8} steals {:>6.1f}% busy\n", i, w.tasks, w.steals, w.utilization() * 100);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    for (std::size_t threads : bench_thread_counts(argc, argv)) {
+        for (auto mode : { ThreadPool::mode::fifo, ThreadPool::mode::work_stealing }) {
+            std::cout << std::format("threads {} {}\n", threads, mode == ThreadPool::mode::fifo ? "fifo" : "work_stealing");
+            std::cout << std::format("{:>6} {:>10} {:>8} {:>8} {:>10} {:>10} {:>10} {:>10} {:>10}\n", "round",
+                "tasks", "depth", "peak", "wait p50", "wait p99", "exec p50", "exec p99", "steals");
+            ThreadPool pool{ threads, mode };
+            run(pool);
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <format>
+#include <vector>
+#include "../ThreadPool.h"
+#include "Bench.h"
+
+// 数据并行循环：y[i] = sqrt(x[i]) * a + y[i]，以及对 x 求平方和
+//   serial   : 单线程
+//   submit   : 手动按线程数切成块，每块一个 submit + future
+//   par_for  : parallel_for，默认 grain
+//   reduce   : parallel_reduce 求平方和
+// 表中是毫秒数，取 5 次中的最小值。用法：parallel_for_bench [线程数列表]
+
+constexpr std::size_t n    = 1 << 23;
+constexpr int         reps = 5;
+
+template<typename F>
+double best_ms(F&& f) {
+    double best = 1e300;
+    for (int i = 0; i < reps; ++i)
+        best = std::min(best, bench_seconds(f) * 1e3);
+    return best;
+}
+
+void kernel(const std::vector<double>& x, std::vector<double>& y, std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i)
+        y[i] = std::sqrt(x[i]) * 1.5 + y[i];
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<double> x(n), y(n);
+    for (std::size_t i = 0; i < n; ++i)
+        x[i] = static_cast<double>(i % 1000);
+    double expected_sum = 0;
+    for (double v : x)
+        expected_sum += v * v;
+
+    double serial = best_ms([&] { kernel(x, y, 0, n); });
+
+    std::cout << std::format("{:>8} {:>14} {:>10} {:>10} {:>10} {:>10}\n", "threads", "mode", "serial", "submit", "par_for", "reduce");
+    for (std::size_t threads : bench_thread_counts(argc, argv)) {
+        for (auto mode : { ThreadPool::mode::fifo, ThreadPool::mode::work_stealing }) {
+            ThreadPool pool{ threads, mode };
+
+            double manual = best_ms([&] {
+                std::vector<task_future<void>> futures;
+                std::size_t chunk = (n + threads - 1) / threads;
+                for (std::size_t begin = 0; begin < n; begin += chunk)
+                    futures.push_back(pool.submit(kernel, std::cref(x), std::ref(y), begin, std::min(n, begin + chunk)));
+                for (auto& future : futures)
+                    future.get();
+            });
+
+            double par_for = best_ms([&] {
+                pool.parallel_for(std::size_t{ 0 }, n, [&](std::size_t begin, std::size_t end) { kernel(x, y, begin, end); });
+            });
+
+            double sum = 0;
+            double reduce = best_ms([&] {
+                sum = pool.parallel_reduce(std::size_t{ 0 }, n, 0.0,
+                    [&](std::size_t begin, std::size_t end, double acc) {
+                        for (std::size_t i = begin; i < end; ++i)
+                            acc += x[i] * x[i];
+                        return acc;
+                    },
+                    std::plus<>{});
+            });
+            if (sum != expected_sum) // 元素都是整数，和在 2^53 以内，结果是精确的
+                std::abort();
+
+            std::cout << std::format("{:>8} {:>14} {:>10.2f} {:>10.2f} {:>10.2f} {:>10.2f}\n", threads,
+                mode == ThreadPool::mode::fifo ? "fifo" : "work_stealing", serial, manual, par_for, reduce);
+        }
+    }
+}
@@ -0,0 +1,78 @@
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <format>
+#include <numeric>
+#include <thread>
+#include <vector>
+#include "../ThreadPool.h"
+#include "Bench.h"
+
+// 工作线程放置策略对内存密集型任务的影响。
+// 每个 NUMA 节点一个提交线程，绑定在该节点上，数据由它首次写入（所以页面分配在该节点），
+// 提交的任务各自把数据里的一块（64KB）读一遍求和。任务在别的节点上执行时要跨节点读内存。
+// 单节点机器上各策略只差在绑核与否。表中是每秒完成的任务数（千）。
+// 用法：placement_bench [线程数列表]
+
+constexpr std::size_t block_bytes      = 64 * 1024;
+constexpr std::size_t blocks_per_node  = 256; // 每个节点 16MB，超过大多数机器单个核能用的缓存
+constexpr long        tasks_per_node   = 20'000;
+
+double run(ThreadPool& pool) {
+    const cpu_topology& topology = cpu_topology::get();
+    std::size_t nodes = topology.node_count();
+    bench_countdown done{ static_cast<long>(nodes) * tasks_per_node };
+    std::atomic<std::uint64_t> checksum{ 0 };
+
+    // 先在各节点上准备好数据，再统一开始计时
+    std::vector<std::vector<std::uint64_t>> data(nodes);
+    {
+        std::vector<std::jthread> writers;
+        for (std::size_t n = 0; n < nodes; ++n) {
+            writers.emplace_back([&, n] {
+                auto cpus = topology.node_cpus(n);
+                pin_current_thread(cpus);
+                data[n].resize(blocks_per_node * block_bytes / sizeof(std::uint64_t));
+                std::iota(data[n].begin(), data[n].end(), std::uint64_t{ 0 });
+            });
+        }
+    }
+
+    return bench_seconds([&] {
+        std::vector<std::jthread> submitters;
+        for (std::size_t n = 0; n < nodes; ++n) {
+            submitters.emplace_back([&, n] {
+                auto cpus = topology.node_cpus(n);
+                pin_current_thread(cpus);
+                constexpr std::size_t words = block_bytes / sizeof(std::uint64_t);
+                for (long i = 0; i < tasks_per_node; ++i) {
+                    const std::uint64_t* block = data[n].data() + (i % blocks_per_node) * words;
+                    pool.post([&, block] {
+                        checksum.fetch_add(std::accumulate(block, block + words, std::uint64_t{ 0 }), std::memory_order_relaxed);
+                        done.count_down();
+                    });
+                }
+            });
+        }
+        done.wait();
+    });
+}
+
+int main(int argc, char* argv[]) {
+    const cpu_topology& topology = cpu_topology::get();
+    std::cout << std::format("{} CPUs, {} NUMA nodes\n", topology.cpus().size(), topology.node_count());
+    std::cout << std::format("{:>8} {:>14} {:>12} {:>12} {:>12} {:>12}\n", "threads", "mode", "none", "compact", "scatter", "numa_nodes");
+    for (std::size_t threads : bench_thread_counts(argc, argv)) {
+        for (auto mode : { ThreadPool::mode::fifo, ThreadPool::mode::work_stealing }) {
+            std::cout << std::format("{:>8} {:>14}", threads, mode == ThreadPool::mode::fifo ? "fifo" : "work_stealing");
+            for (auto p : { ThreadPool::placement::none, ThreadPool::placement::compact,
+                            ThreadPool::placement::scatter, ThreadPool::placement::numa_nodes }) {
+                ThreadPool pool{ threads, mode, p };
+                run(pool); // 预热
+                double seconds = run(pool);
+                std::cout << std::format(" {:>12.1f}", topology.node_count() * tasks_per_node / seconds / 1e3);
+            }
+            std::cout << '\n';
+        }
+    }
+}
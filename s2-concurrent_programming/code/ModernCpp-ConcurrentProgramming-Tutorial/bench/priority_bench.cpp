@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <iostream>
+#include <format>
+#include <vector>
+#include "../ThreadPool.h"
+#include "Bench.h"
+
+// 后台任务占满线程池时，探测任务从提交到开始执行的延迟（微秒）
+//   all normal     : 后台和探测都是默认优先级（原来的纯 FIFO 行为）
+//   high over low  : 后台 low，探测 high
+//   edf deadline   : 都是 normal，探测带 200us 的截止时间。没有截止时间的任务按“入队时间 + aging（10ms）”
+//                    参与 EDF，所以 fifo 模式下探测仍排在已经等了超过 10ms 的后台任务后面；
+//                    work_stealing 模式下工作线程看到截止时间临近的任务会先去全局队列取它，不再先执行本地任务
+// 后台保持每个线程 32 个 50us 的任务在排队，每个执行完会重新提交自己（work_stealing 模式下进本地队列）。
+// 用法：priority_bench [线程数列表]
+
+using namespace std::chrono_literals;
+
+constexpr int                background_per_thread = 32;
+constexpr auto               background_work       = 50us;
+constexpr int                num_probes            = 2000;
+constexpr auto               probe_interval        = 500us;
+
+void busy_for(bench_clock::duration d) {
+    auto end = bench_clock::now() + d;
+    while (bench_clock::now() < end)
+        bench_spin(64);
+}
+
+struct background {
+    ThreadPool&               pool;
+    ThreadPool::task_options  options;
+    std::atomic<bool>         running{ true };
+    std::atomic<long>         in_flight{ 0 };
+
+    void spawn() {
+        in_flight.fetch_add(1);
+        pool.post(options, [this] { run(); });
+    }
+    void run() {
+        busy_for(background_work);
+        if (running.load(std::memory_order_relaxed))
+            pool.post(options, [this] { run(); }); // 在飞的数量不变
+        else if (in_flight.fetch_sub(1) == 1)
+            in_flight.notify_all();
+    }
+    void stop() {
+        running = false;
+        for (long n = in_flight.load(); n != 0; n = in_flight.load())
+            in_flight.wait(n);
+    }
+};
+
+struct percentiles {
+    double p50, p99, max;
+};
+
+percentiles run(ThreadPool& pool, std::size_t threads, ThreadPool::task_options background_options,
+                ThreadPool::priority probe_priority, bool probe_deadline) {
+    background bg{ pool, background_options };
+    for (std::size_t i = 0; i < threads * background_per_thread; ++i)
+        bg.spawn();
+    std::this_thread::sleep_for(20ms); // 让队列进入稳态
+
+    std::vector<double> latency(num_probes);
+    bench_countdown done{ num_probes };
+    for (int i = 0; i < num_probes; ++i) {
+        auto submitted = bench_clock::now();
+        ThreadPool::task_options options{ probe_priority };
+        if (probe_deadline)
+            options.deadline = submitted + 200us;
+        pool.post(options, [&, i, submitted] {
+            latency[i] = std::chrono::duration<double, std::micro>(bench_clock::now() - submitted).count();
+            done.count_down();
+        });
+        std::this_thread::sleep_for(probe_interval);
+    }
+    done.wait();
+    bg.stop();
+
+    std::sort(latency.begin(), latency.end());
+    return { latency[num_probes / 2], latency[num_probes * 99 / 100], latency.back() };
+}
+
+int main(int argc, char* argv[]) {
+    using priority = ThreadPool::priority;
+    std::cout << std::format("{:>8} {:>14} {:>16} {:>10} {:>10} {:>10}\n", "threads", "mode", "scenario", "p50(us)", "p99(us)", "max(us)");
+    for (std::size_t threads : bench_thread_counts(argc, argv)) {
+        for (auto mode : { ThreadPool::mode::fifo, ThreadPool::mode::work_stealing }) {
+            struct scenario {
+                const char* name;
+                priority    background;
+                priority    probe;
+                bool        deadline;
+            };
+            for (auto [name, background_priority, probe_priority, deadline] : {
+                     scenario{ "all normal", priority::normal, priority::normal, false },
+                     scenario{ "high over low", priority::low, priority::high, false },
+                     scenario{ "edf deadline", priority::normal, priority::normal, true } }) {
+                ThreadPool pool{ threads, mode };
+                auto result = run(pool, threads, background_priority, probe_priority, deadline);
+                std::cout << std::format("{:>8} {:>14} {:>16} {:>10.1f} {:>10.1f} {:>10.1f}\n", threads,
+                    mode == ThreadPool::mode::fifo ? "fifo" : "work_stealing", name, result.p50, result.p99, result.max);
+            }
+        }
+    }
+}
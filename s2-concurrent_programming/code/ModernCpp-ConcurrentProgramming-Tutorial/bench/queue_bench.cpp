@@ -0,0 +1,78 @@
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <format>
+#include <thread>
+#include <vector>
+#include "../ThreadsafeQueue.h"
+#include "../MPMCQueue.h"
+#include "Bench.h"
+
+// 生产者/消费者吞吐量：N 个生产者和 N 个消费者通过一个队列传递整数
+//   threadsafe_queue : 互斥量 + 条件变量 + std::queue
+//   mpmc blocking    : mpmc_queue 的 push/pop（atomic::wait）
+//   mpmc try+yield   : mpmc_queue 的 try_push/try_pop，失败就让出时间片
+// 用法：queue_bench [每侧线程数列表，如 1,2,4]
+
+constexpr std::uint64_t total_items   = 2'000'000;
+constexpr std::size_t   mpmc_capacity = 1024;
+
+// 每个消费者弹出固定个数，阻塞式接口也能确定地结束；最后核对总和
+template<typename Push, typename Pop>
+double run(std::size_t pairs, Push push, Pop pop) {
+    std::uint64_t per_producer = total_items / pairs;
+    std::uint64_t items = per_producer * pairs;
+    std::atomic<std::uint64_t> sum{ 0 };
+
+    double seconds = bench_seconds([&] {
+        std::vector<std::jthread> threads;
+        for (std::size_t c = 0; c < pairs; ++c) {
+            std::uint64_t count = items / pairs + (c < items % pairs ? 1 : 0);
+            threads.emplace_back([&, count] {
+                std::uint64_t local = 0;
+                for (std::uint64_t i = 0; i < count; ++i)
+                    local += pop();
+                sum.fetch_add(local);
+            });
+        }
+        for (std::size_t p = 0; p < pairs; ++p) {
+            threads.emplace_back([&, p] {
+                for (std::uint64_t i = 0; i < per_producer; ++i)
+                    push(p * per_producer + i + 1);
+            });
+        }
+    });
+
+    if (sum != items * (items + 1) / 2) {
+        std::cerr << "checksum mismatch\n";
+        std::abort();
+    }
+    return items / seconds / 1e6;
+}
+
+int main(int argc, char* argv[]) {
+    std::cout << std::format("{:>8} {:>18} {:>18} {:>18}\n", "pairs",
+        "threadsafe(M/s)", "mpmc block(M/s)", "mpmc try(M/s)");
+    for (std::size_t pairs : bench_thread_counts(argc, argv)) {
+        double locked = 0, blocking = 0, spinning = 0;
+        {
+            threadsafe_queue<std::uint64_t> q;
+            locked = run(pairs,
+                [&](std::uint64_t v) { q.push(v); },
+                [&] { std::uint64_t v; q.pop(v); return v; });
+        }
+        {
+            mpmc_queue<std::uint64_t> q{ mpmc_capacity };
+            blocking = run(pairs,
+                [&](std::uint64_t v) { q.push(v); },
+                [&] { return q.pop(); });
+        }
+        {
+            mpmc_queue<std::uint64_t> q{ mpmc_capacity };
+            spinning = run(pairs,
+                [&](std::uint64_t v) { while (!q.try_push(v)) std::this_thread::yield(); },
+                [&] { std::uint64_t v; while (!q.try_pop(v)) std::this_thread::yield(); return v; });
+        }
+        std::cout << std::format("{:>8} {:>18.3f} {:>18.3f} {:>18.3f}\n", pairs, locked, blocking, spinning);
+    }
+}
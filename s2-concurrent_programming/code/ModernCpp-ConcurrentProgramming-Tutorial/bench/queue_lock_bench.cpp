@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <format>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../QueueLock.h"
+#include "../SpinLock.h"
+#include "Bench.h"
+
+// 排队锁和其它锁在竞争下的比较：N 个线程在 duration 内反复加锁，临界区里做 cs 次空循环，
+// 锁外做 outside 次空循环。
+//   Mops/s   : 吞吐量
+//   jain     : 各线程加锁次数的 Jain 公平指数，1 表示完全平均，1/N 表示只有一个线程拿到锁
+//   min/max  : 拿得最少的线程和最多的线程的加锁次数之比
+//   handoff  : 一个线程解锁到另一个线程拿到锁的时间（微秒）的中位数和 p99
+// 用法：queue_lock_bench [线程数列表]
+
+using namespace std::chrono_literals;
+
+constexpr auto     duration = 200ms;
+constexpr unsigned cs       = 50;
+constexpr unsigned outside  = 200;
+
+struct result {
+    double mops;
+    double jain;
+    double min_max;
+    double handoff_p50, handoff_p99;
+};
+
+template<typename Mutex>
+result run(std::size_t threads) {
+    Mutex m;
+    std::atomic<bool> stop{ false };
+    // 以下两个只在持锁时读写
+    std::size_t       last_owner = threads;
+    bench_clock::time_point last_unlock{};
+
+    std::vector<std::uint64_t> counts(threads);
+    std::vector<std::vector<double>> handoffs(threads);
+    double seconds = bench_seconds([&] {
+        std::vector<std::jthread> workers;
+        for (std::size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                std::uint64_t count = 0;
+                auto& samples = handoffs[t];
+                while (!stop.load(std::memory_order_relaxed)) {
+                    {
+                        std::lock_guard<Mutex> lc{ m };
+                        if (last_owner != t && last_owner != threads)
+                            samples.push_back(std::chrono::duration<double, std::micro>(bench_clock::now() - last_unlock).count());
+                        bench_spin(cs);
+                        last_owner = t;
+                        last_unlock = bench_clock::now();
+                    }
+                    ++count;
+                    bench_spin(outside);
+                }
+                counts[t] = count;
+            });
+        }
+        std::this_thread::sleep_for(duration);
+        stop = true;
+    });
+
+    double sum = 0, sum_sq = 0;
+    for (auto c : counts) {
+        sum += static_cast<double>(c);
+        sum_sq += static_cast<double>(c) * static_cast<double>(c);
+    }
+    auto [min, max] = std::minmax_element(counts.begin(), counts.end());
+    std::vector<double> all;
+    for (auto& samples : handoffs)
+        all.insert(all.end(), samples.begin(), samples.end());
+    std::sort(all.begin(), all.end());
+    auto percentile = [&](double q) { return all.empty() ? 0.0 : all[static_cast<std::size_t>(q * static_cast<double>(all.size() - 1))]; };
+    return { sum / seconds / 1e6, sum_sq == 0 ? 0.0 : sum * sum / (static_cast<double>(threads) * sum_sq),
+             *max == 0 ? 0.0 : static_cast<double>(*min) / static_cast<double>(*max), percentile(0.5), percentile(0.99) };
+}
+
+template<typename Mutex>
+void report(std::size_t threads, const char* name) {
+    result r = run<Mutex>(threads);
+    std::cout << std::format("{:>8} {:>12} {:>10.3f} {:>8.3f} {:>8.3f} {:>12.2f} {:>12.2f}\n",
+        threads, name, r.mops, r.jain, r.min_max, r.handoff_p50, r.handoff_p99);
+}
+
+int main(int argc, char* argv[]) {
+    std::cout << std::format("{:>8} {:>12} {:>10} {:>8} {:>8} {:>12} {:>12}\n",
+        "threads", "lock", "Mops/s", "jain", "min/max", "handoff p50", "handoff p99");
+    for (std::size_t threads : bench_thread_counts(argc, argv)) {
+        report<spinlock_mutex>(threads, "spinlock");
+        report<adaptive_mutex>(threads, "adaptive");
+        report<std::mutex>(threads, "std::mutex");
+        report<ticket_mutex>(threads, "ticket");
+        report<mcs_mutex>(threads, "mcs");
+    }
+}
@@ -0,0 +1,103 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <format>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../Settings.h"
+#include "Bench.h"
+
+// 读者扩展性：N 个读线程不停地查配置表（num_keys 项），一个写线程每 write_interval 改一项。
+//   shared_mutex : 19保护不常更新的数据结构.cpp 里的 Settings，读锁 + 复制字符串
+//   snapshot     : rcu_settings::snapshot()，每次读都取一次 atomic<shared_ptr>（修改引用计数）
+//   reader       : rcu_settings::reader，读路径上没有读-改-写，返回 string_view
+// 表中是所有读线程合计每秒的查找次数（百万）。用法：settings_bench [读线程数列表]
+
+using namespace std::chrono_literals;
+
+constexpr int  num_keys       = 64;
+constexpr auto duration       = 200ms;
+constexpr auto write_interval = 1ms;
+
+class Settings {
+private:
+    std::map<std::string, std::string> data_;
+    mutable std::shared_timed_mutex mutex_;
+
+public:
+    void set(const std::string& key, const std::string& value) {
+        std::lock_guard<std::shared_timed_mutex> lock{ mutex_ };
+        data_[key] = value;
+    }
+
+    std::string get(const std::string& key) const {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex_);
+        auto it = data_.find(key);
+        return (it != data_.end()) ? it->second : "";
+    }
+};
+
+std::vector<std::string> make_keys() {
+    std::vector<std::string> keys;
+    for (int i = 0; i < num_keys; ++i)
+        keys.push_back(std::format("service.option_{}", i));
+    return keys;
+}
+
+// make_reader() 为每个读线程创建读取状态，lookup(state, key) 返回值的长度（防止被优化掉）
+template<typename Store, typename MakeReader, typename Lookup>
+double run(std::size_t readers, Store& store, MakeReader make_reader, Lookup lookup) {
+    static const std::vector<std::string> keys = make_keys();
+    for (const auto& key : keys)
+        store.set(key, "value of " + key);
+
+    std::atomic<bool> stop{ false };
+    std::atomic<std::uint64_t> total{ 0 };
+    double seconds = bench_seconds([&] {
+        std::vector<std::jthread> threads;
+        for (std::size_t r = 0; r < readers; ++r) {
+            threads.emplace_back([&, r] {
+                auto state = make_reader();
+                std::uint64_t count = 0, length = 0;
+                for (std::size_t i = r; !stop.load(std::memory_order_relaxed); ++i, ++count)
+                    length += lookup(state, keys[i % keys.size()]);
+                if (length == 0)
+                    std::abort();
+                total.fetch_add(count);
+            });
+        }
+        threads.emplace_back([&] {
+            for (int i = 0; !stop.load(std::memory_order_relaxed); ++i) {
+                store.set(keys[i % keys.size()], std::format("value {}", i));
+                std::this_thread::sleep_for(write_interval);
+            }
+        });
+        std::this_thread::sleep_for(duration);
+        stop = true;
+    });
+    return static_cast<double>(total.load()) / seconds / 1e6;
+}
+
+int main(int argc, char* argv[]) {
+    std::cout << std::format("{:>8} {:>14} {:>14} {:>14}\n", "readers", "shared_mutex", "snapshot", "reader");
+    for (std::size_t readers : bench_thread_counts(argc, argv)) {
+        Settings locked;
+        double a = run(readers, locked, [] { return 0; },
+            [&](int, const std::string& key) { return locked.get(key).size(); });
+
+        rcu_settings rcu;
+        double b = run(readers, rcu, [] { return 0; },
+            [&](int, const std::string& key) { return rcu.snapshot()->get(key).size(); });
+
+        rcu_settings rcu2;
+        double c = run(readers, rcu2, [&] { return rcu2.make_reader(); },
+            [](rcu_settings::reader& reader, const std::string& key) { return reader.get(key).size(); });
+
+        std::cout << std::format("{:>8} {:>14.2f} {:>14.2f} {:>14.2f}\n", readers, a, b, c);
+    }
+}
@@ -0,0 +1,86 @@
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <format>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "../EpochReclamation.h"
+#include "Bench.h"
+
+// 读多写少的共享对象：N 个读线程不停地读一份配置，一个写线程每 write_interval 整体替换一次。
+//   atomic<shared_ptr> : 45原子特化shared_ptr.cpp 的做法，每次 load 都要修改引用计数
+//                        （libstdc++ 还要加一次内部的自旋锁）
+//   snapshot read      : atomic_snapshot::read，登记纪元后读一次指针，读者之间不写任何共享数据
+//   snapshot load      : atomic_snapshot::load，返回持有纪元的 read_guard
+// 表中是所有读线程合计每秒的读取次数（百万），pending 是结束时还没释放的旧配置个数。
+// 用法：snapshot_bench [读线程数列表]
+
+using namespace std::chrono_literals;
+
+constexpr auto duration       = 200ms;
+constexpr auto write_interval = 1ms;
+
+struct config {
+    std::array<int, 16> values{};
+};
+
+// store(c) 发布一份新配置，read(i) 返回当前配置里的第 i 个值
+template<typename Store, typename Read>
+double run(std::size_t readers, Store store, Read read) {
+    std::atomic<bool> stop{ false };
+    std::atomic<std::uint64_t> total{ 0 };
+    double seconds = bench_seconds([&] {
+        std::vector<std::jthread> threads;
+        for (std::size_t r = 0; r < readers; ++r) {
+            threads.emplace_back([&, r] {
+                std::uint64_t count = 0, sum = 0;
+                for (std::size_t i = r; !stop.load(std::memory_order_relaxed); ++i, ++count)
+                    sum += static_cast<std::uint64_t>(read(i % 16));
+                if (sum == 0)
+                    std::abort();
+                total.fetch_add(count);
+            });
+        }
+        threads.emplace_back([&] {
+            for (int i = 1; !stop.load(std::memory_order_relaxed); ++i) {
+                config c;
+                c.values.fill(i);
+                store(c);
+                std::this_thread::sleep_for(write_interval);
+            }
+        });
+        std::this_thread::sleep_for(duration);
+        stop = true;
+    });
+    return static_cast<double>(total.load()) / seconds / 1e6;
+}
+
+config initial() {
+    config c;
+    c.values.fill(1);
+    return c;
+}
+
+int main(int argc, char* argv[]) {
+    std::cout << std::format("{:>8} {:>18} {:>16} {:>16} {:>8}\n", "readers", "atomic<shared_ptr>", "snapshot read", "snapshot load", "pending");
+    for (std::size_t readers : bench_thread_counts(argc, argv)) {
+        std::atomic<std::shared_ptr<const config>> shared{ std::make_shared<const config>(initial()) };
+        double a = run(readers,
+            [&](const config& c) { shared.store(std::make_shared<const config>(c)); },
+            [&](std::size_t i) { return shared.load()->values[i]; });
+
+        epoch_domain domain;
+        atomic_snapshot<config> snapshot{ initial(), domain };
+        double b = run(readers,
+            [&](const config& c) { snapshot.store(c); },
+            [&](std::size_t i) { return snapshot.read([i](const config& c) { return c.values[i]; }); });
+        double c = run(readers,
+            [&](const config& c) { snapshot.store(c); },
+            [&](std::size_t i) { return snapshot.load()->values[i]; });
+
+        std::cout << std::format("{:>8} {:>18.2f} {:>16.2f} {:>16.2f} {:>8}\n", readers, a, b, c, domain.pending());
+    }
+}
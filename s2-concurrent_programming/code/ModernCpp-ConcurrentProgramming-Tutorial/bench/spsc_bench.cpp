@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <format>
+#include <thread>
+#include <vector>
+#include "../ThreadsafeQueue.h"
+#include "../SPSCQueue.h"
+#include "Bench.h"
+
+// 单生产者单消费者：
+//   latency    : 两个队列来回传一个整数（乒乓），往返时间的一半即单程交接延迟
+//   throughput : 单向传递大量整数，逐个 push/pop 对比一次 64 个的批量接口
+// 两端必须各占一个核，spin 模式的数字才有意义。
+// 用法：spsc_bench（线程数固定为 2，不接受参数）
+
+constexpr int           ping_pongs  = 200'000;
+constexpr std::uint64_t total_items = 20'000'000;
+constexpr std::size_t   capacity    = 1024;
+constexpr std::size_t   batch       = 64;
+
+template<typename Queue, typename Push, typename Pop>
+double one_way_ns(Queue& ping, Queue& pong, Push push, Pop pop) {
+    std::jthread echo{ [&] {
+        for (int i = 0; i < ping_pongs; ++i)
+            push(pong, pop(ping));
+    } };
+    double seconds = bench_seconds([&] {
+        for (int i = 0; i < ping_pongs; ++i) {
+            push(ping, std::uint64_t(i));
+            if (pop(pong) != std::uint64_t(i))
+                std::abort();
+        }
+    });
+    return seconds / ping_pongs / 2 * 1e9;
+}
+
+double spsc_latency(spsc_wait wait) {
+    spsc_queue<std::uint64_t> ping{ capacity, wait }, pong{ capacity, wait };
+    return one_way_ns(ping, pong,
+        [](auto& q, std::uint64_t v) { q.push(v); },
+        [](auto& q) { return q.pop(); });
+}
+
+double locked_latency() {
+    threadsafe_queue<std::uint64_t> ping, pong;
+    return one_way_ns(ping, pong,
+        [](auto& q, std::uint64_t v) { q.push(v); },
+        [](auto& q) { std::uint64_t v; q.pop(v); return v; });
+}
+
+template<typename Producer, typename Consumer>
+double throughput(Producer producer, Consumer consumer) {
+    std::uint64_t sum = 0;
+    double seconds = bench_seconds([&] {
+        std::jthread t{ producer };
+        sum = consumer();
+    });
+    if (sum != total_items * (total_items - 1) / 2)
+        std::abort();
+    return total_items / seconds / 1e6;
+}
+
+double spsc_single(spsc_wait wait) {
+    spsc_queue<std::uint64_t> q{ capacity, wait };
+    return throughput(
+        [&] { for (std::uint64_t i = 0; i < total_items; ++i) q.push(i); },
+        [&] { std::uint64_t sum = 0; for (std::uint64_t i = 0; i < total_items; ++i) sum += q.pop(); return sum; });
+}
+
+double spsc_batch(spsc_wait wait) {
+    spsc_queue<std::uint64_t> q{ capacity, wait };
+    return throughput(
+        [&] {
+            std::array<std::uint64_t, batch> values;
+            for (std::uint64_t i = 0; i < total_items; i += batch) {
+                std::size_t n = std::min<std::uint64_t>(batch, total_items - i);
+                for (std::size_t k = 0; k < n; ++k)
+                    values[k] = i + k;
+                q.push(std::span<const std::uint64_t>{ values.data(), n });
+            }
+        },
+        [&] {
+            std::array<std::uint64_t, batch> values;
+            std::uint64_t sum = 0;
+            for (std::uint64_t received = 0; received < total_items;) {
+                std::size_t n = q.pop(std::span{ values });
+                for (std::size_t k = 0; k < n; ++k)
+                    sum += values[k];
+                received += n;
+            }
+            return sum;
+        });
+}
+
+double locked_single() {
+    threadsafe_queue<std::uint64_t> q;
+    return throughput(
+        [&] { for (std::uint64_t i = 0; i < total_items; ++i) q.push(i); },
+        [&] { std::uint64_t sum = 0, v; for (std::uint64_t i = 0; i < total_items; ++i) { q.pop(v); sum += v; } return sum; });
+}
+
+int main() {
+    std::cout << std::format("{:<22} {:>14} {:>16} {:>16}\n", "queue", "one-way(ns)", "single(M/s)", "batch64(M/s)");
+    std::cout << std::format("{:<22} {:>14.1f} {:>16.3f} {:>16}\n", "threadsafe_queue", locked_latency(), locked_single(), "-");
+    for (auto wait : { spsc_wait::spin, spsc_wait::block }) {
+        std::cout << std::format("{:<22} {:>14.1f} {:>16.3f} {:>16.3f}\n",
+            wait == spsc_wait::spin ? "spsc_queue(spin)" : "spsc_queue(block)",
+            spsc_latency(wait), spsc_single(wait), spsc_batch(wait));
+    }
+}
@@ -0,0 +1,115 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <format>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+#include "../LockFreeStack.h"
+#include "Bench.h"
+
+// 共享栈和对象池：N 个线程在 duration 内反复 push 一个值再 pop 一个值（栈），
+// 或者分配一个对象再归还（池），表中是所有线程合计每秒完成的次数（百万）。
+//   mutex           : std::mutex 保护的 std::vector
+//   free_list       : treiber_stack，节点进空闲链表重复使用
+//   epoch           : treiber_stack，节点交给纪元域回收
+//   new/delete      : 直接 new/delete 一个对象
+//   pool            : lock_free_free_list 的 create/destroy
+// 用法：stack_bench [线程数列表]
+
+using namespace std::chrono_literals;
+
+constexpr auto duration = 200ms;
+
+struct payload {
+    long values[6];
+    explicit payload(long v) {
+        for (auto& x : values)
+            x = v;
+    }
+};
+
+template<typename F>
+double run(std::size_t threads, F op) {
+    std::atomic<bool> stop{ false };
+    std::atomic<std::uint64_t> total{ 0 };
+    double seconds = bench_seconds([&] {
+        std::vector<std::jthread> workers;
+        for (std::size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                std::uint64_t count = 0, sum = 0;
+                for (; !stop.load(std::memory_order_relaxed); ++count)
+                    sum += op(static_cast<long>(t + count));
+                if (sum == 0)
+                    std::abort();
+                total.fetch_add(count);
+            });
+        }
+        std::this_thread::sleep_for(duration);
+        stop = true;
+    });
+    return static_cast<double>(total.load()) / seconds / 1e6;
+}
+
+class locked_stack {
+public:
+    void push(long v) {
+        std::lock_guard<std::mutex> lc{ mutex_ };
+        data_.push_back(v);
+    }
+    std::optional<long> pop() {
+        std::lock_guard<std::mutex> lc{ mutex_ };
+        if (data_.empty())
+            return std::nullopt;
+        long v = data_.back();
+        data_.pop_back();
+        return v;
+    }
+private:
+    std::mutex        mutex_;
+    std::vector<long> data_;
+};
+
+int main(int argc, char* argv[]) {
+    std::cout << std::format("{:>8} {:>10} {:>10} {:>10} {:>12} {:>10}\n",
+        "threads", "mutex", "free_list", "epoch", "new/delete", "pool");
+    for (std::size_t threads : bench_thread_counts(argc, argv)) {
+        locked_stack locked;
+        double a = run(threads, [&](long v) {
+            locked.push(v);
+            return locked.pop().value_or(0) | 1;
+        });
+
+        treiber_stack<long> recycled;
+        double b = run(threads, [&](long v) {
+            recycled.push(v);
+            return recycled.pop().value_or(0) | 1;
+        });
+
+        epoch_domain domain;
+        treiber_stack<long, stack_reclaim::epoch> reclaimed{ domain };
+        double c = run(threads, [&](long v) {
+            reclaimed.push(v);
+            return reclaimed.pop().value_or(0) | 1;
+        });
+
+        double d = run(threads, [](long v) {
+            auto* p = new payload{ v };
+            long r = p->values[5] | 1;
+            delete p;
+            return r;
+        });
+
+        lock_free_free_list<payload> pool{ threads };
+        double e = run(threads, [&](long v) {
+            payload* p = pool.create(v);
+            long r = p->values[5] | 1;
+            pool.destroy(p);
+            return r;
+        });
+
+        std::cout << std::format("{:>8} {:>10.2f} {:>10.2f} {:>10.2f} {:>12.2f} {:>10.2f}\n", threads, a, b, c, d, e);
+    }
+}
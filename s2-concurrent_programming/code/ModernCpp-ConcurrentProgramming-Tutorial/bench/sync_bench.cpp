@@ -0,0 +1,367 @@
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <format>
+#include <latch>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <semaphore>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "../SpinLock.h"
+#include "Bench.h"
+
+// 教程 11–45 里的同步原语在竞争下的表现。每个组合跑 duration：N 个线程反复加锁，
+// 临界区里做 cs 次空循环，锁外做 outside 次；读写锁和原子变量按写比例随机选择读或写。
+//   mutex / unique_lock / recursive_mutex（嵌套加锁两层）/ try_lock（失败时先做别的事再试）
+//   shared_mutex（读用 shared_lock）/ atomic（读是 load，写是 fetch_add，没有临界区）
+//   atomic_flag（SpinLock.h 的 spinlock_mutex）/ binary_semaphore / counting_semaphore（4 个许可）
+//   latch / barrier：每轮做 cs 次空循环后到达并等待其余线程，一轮算每个线程一次操作
+// 输出的列：
+//   Mops/s         所有线程合计每秒的操作数
+//   jain           各线程操作数的 Jain 公平指数，1 表示完全平均，1/N 表示只有一个线程在做
+//   min/max share  做得最少和最多的线程占总数的比例（平均是 1/N）
+//   p50/p90/p99    交接延迟（微秒）：一个线程解锁到另一个线程拿到锁；latch/barrier 是最后一个线程到达到各线程醒来。
+//                  每 8 次解锁采样一次；允许多个持有者的原语（读锁、计数信号量、原子变量）不统计
+// 用法：sync_bench [线程数列表] [cs 列表] [写百分比列表] [table|csv|json]
+// csv 和 json（每行一个对象，带每个线程的份额）适合保存下来和以后的结果比较。
+
+using namespace std::chrono_literals;
+
+constexpr auto     duration     = 200ms;
+constexpr unsigned outside      = 100;
+constexpr unsigned sample_every = 8;
+constexpr int      latch_rounds = 2000;
+
+enum class output { table, csv, json };
+
+struct config {
+    std::size_t threads;
+    unsigned    cs;
+    unsigned    write_percent; // 只对 shared_mutex 和 atomic 有意义，其它原语输出 100
+};
+
+struct alignas(64) thread_stats {
+    std::uint64_t       ops = 0;
+    std::vector<double> handoffs; // 微秒
+};
+
+double elapsed_us(bench_clock::time_point since) {
+    return std::chrono::duration<double, std::micro>(bench_clock::now() - since).count();
+}
+
+// 交接延迟的采样，只在持有排他锁时访问
+class handoff_tracker {
+public:
+    void acquired(std::size_t t, thread_stats& stats) {
+        if (stamped_ && owner_ != t)
+            stats.handoffs.push_back(elapsed_us(stamp_));
+        stamped_ = false;
+    }
+    void releasing(std::size_t t, std::uint64_t ops) {
+        owner_ = t;
+        stamped_ = ops % sample_every == 0;
+        if (stamped_)
+            stamp_ = bench_clock::now();
+    }
+private:
+    std::size_t             owner_ = static_cast<std::size_t>(-1);
+    bool                    stamped_ = false;
+    bench_clock::time_point stamp_{};
+};
+
+struct result {
+    std::string_view          primitive;
+    config                    cfg;
+    double                    seconds;
+    std::vector<thread_stats> stats;
+};
+
+// op(t, stats, rng) 做一次操作；所有线程一直做到 duration 结束
+template<typename Op>
+result run(std::string_view name, const config& cfg, Op op) {
+    std::atomic<bool> stop{ false };
+    std::vector<thread_stats> stats(cfg.threads);
+    double seconds = bench_seconds([&] {
+        std::vector<std::jthread> workers;
+        for (std::size_t t = 0; t < cfg.threads; ++t) {
+            workers.emplace_back([&, t] {
+                std::minstd_rand rng{ static_cast<unsigned>(t + 1) };
+                thread_stats& s = stats[t];
+                while (!stop.load(std::memory_order_relaxed)) {
+                    op(t, s, rng);
+                    ++s.ops;
+                }
+            });
+        }
+        std::this_thread::sleep_for(duration);
+        stop = true;
+    });
+    return { name, cfg, seconds, std::move(stats) };
+}
+
+// lock/unlock 的排他原语，带交接延迟采样
+template<typename Lock, typename Unlock>
+result run_exclusive(std::string_view name, const config& cfg, Lock lock, Unlock unlock) {
+    handoff_tracker tracker;
+    return run(name, cfg, [&](std::size_t t, thread_stats& s, std::minstd_rand&) {
+        lock();
+        tracker.acquired(t, s);
+        bench_spin(cfg.cs);
+        tracker.releasing(t, s.ops);
+        unlock();
+        bench_spin(outside);
+    });
+}
+
+std::vector<result> run_exclusive_primitives(const config& cfg) {
+    std::vector<result> results;
+    {
+        std::mutex m;
+        results.push_back(run_exclusive("mutex", cfg, [&] { m.lock(); }, [&] { m.unlock(); }));
+    }
+    {
+        std::mutex m;
+        handoff_tracker tracker;
+        results.push_back(run("unique_lock", cfg, [&](std::size_t t, thread_stats& s, std::minstd_rand&) {
+            std::unique_lock<std::mutex> lc{ m };
+            tracker.acquired(t, s);
+            bench_spin(cfg.cs);
+            tracker.releasing(t, s.ops);
+            lc.unlock();
+            bench_spin(outside);
+        }));
+    }
+    {
+        std::recursive_mutex m;
+        results.push_back(run_exclusive("recursive_mutex", cfg,
+            [&] { m.lock(); m.lock(); }, [&] { m.unlock(); m.unlock(); }));
+    }
+    {
+        std::mutex m;
+        handoff_tracker tracker;
+        results.push_back(run("try_lock", cfg, [&](std::size_t t, thread_stats& s, std::minstd_rand&) {
+            while (!m.try_lock())
+                bench_spin(outside); // 拿不到锁先处理别的
+            tracker.acquired(t, s);
+            bench_spin(cfg.cs);
+            tracker.releasing(t, s.ops);
+            m.unlock();
+            bench_spin(outside);
+        }));
+    }
+    {
+        spinlock_mutex m;
+        results.push_back(run_exclusive("atomic_flag", cfg, [&] { m.lock(); }, [&] { m.unlock(); }));
+    }
+    {
+        std::binary_semaphore sem{ 1 };
+        results.push_back(run_exclusive("binary_semaphore", cfg, [&] { sem.acquire(); }, [&] { sem.release(); }));
+    }
+    {
+        std::counting_semaphore<4> sem{ 4 };
+        results.push_back(run("counting_semaphore", cfg, [&](std::size_t, thread_stats&, std::minstd_rand&) {
+            sem.acquire();
+            bench_spin(cfg.cs);
+            sem.release();
+            bench_spin(outside);
+        }));
+    }
+    return results;
+}
+
+std::vector<result> run_read_write_primitives(const config& cfg) {
+    std::vector<result> results;
+    {
+        std::shared_mutex m;
+        handoff_tracker tracker; // 只有写者采样
+        results.push_back(run("shared_mutex", cfg, [&](std::size_t t, thread_stats& s, std::minstd_rand& rng) {
+            if (rng() % 100 < cfg.write_percent) {
+                std::lock_guard<std::shared_mutex> lc{ m };
+                tracker.acquired(t, s);
+                bench_spin(cfg.cs);
+                tracker.releasing(t, s.ops);
+            }
+            else {
+                std::shared_lock<std::shared_mutex> lc{ m };
+                bench_spin(cfg.cs);
+            }
+            bench_spin(outside);
+        }));
+    }
+    {
+        std::atomic<std::uint64_t> value{ 0 };
+        results.push_back(run("atomic", cfg, [&](std::size_t, thread_stats&, std::minstd_rand& rng) {
+            if (rng() % 100 < cfg.write_percent)
+                value.fetch_add(1, std::memory_order_relaxed);
+            else if (value.load(std::memory_order_relaxed) == static_cast<std::uint64_t>(-1))
+                std::abort();
+            bench_spin(cfg.cs + outside);
+        }));
+    }
+    return results;
+}
+
+std::vector<result> run_phase_primitives(const config& cfg) {
+    std::vector<result> results;
+    {
+        std::atomic<bool> stop{ false };
+        bool done = false;                 // 只在完成函数里写，arrive_and_wait 返回后读
+        bench_clock::time_point completed; // 同上
+        std::barrier sync{ static_cast<std::ptrdiff_t>(cfg.threads), [&]() noexcept {
+            completed = bench_clock::now();
+            done = stop.load(std::memory_order_relaxed);
+        } };
+        std::vector<thread_stats> stats(cfg.threads);
+        double seconds = bench_seconds([&] {
+            std::vector<std::jthread> workers;
+            for (std::size_t t = 0; t < cfg.threads; ++t) {
+                workers.emplace_back([&, t] {
+                    for (thread_stats& s = stats[t];;) {
+                        bench_spin(cfg.cs);
+                        sync.arrive_and_wait();
+                        if (cfg.threads > 1)
+                            s.handoffs.push_back(elapsed_us(completed));
+                        ++s.ops;
+                        if (done)
+                            break;
+                    }
+                });
+            }
+            std::this_thread::sleep_for(duration);
+            stop = true;
+        });
+        results.push_back({ "barrier", cfg, seconds, std::move(stats) });
+    }
+    {
+        // latch 只能用一次，每轮一个，跑固定的轮数
+        struct round {
+            explicit round(std::size_t threads) : done{ static_cast<std::ptrdiff_t>(threads) } {}
+            std::latch                        done;
+            std::atomic<bench_clock::rep>     last_arrival{ 0 };
+        };
+        std::vector<std::unique_ptr<round>> rounds;
+        for (int i = 0; i < latch_rounds; ++i)
+            rounds.push_back(std::make_unique<round>(cfg.threads));
+        std::vector<thread_stats> stats(cfg.threads);
+        double seconds = bench_seconds([&] {
+            std::vector<std::jthread> workers;
+            for (std::size_t t = 0; t < cfg.threads; ++t) {
+                workers.emplace_back([&, t] {
+                    thread_stats& s = stats[t];
+                    for (auto& r : rounds) {
+                        bench_spin(cfg.cs);
+                        auto now = bench_clock::now().time_since_epoch().count();
+                        auto last = r->last_arrival.load(std::memory_order_relaxed);
+                        while (last < now && !r->last_arrival.compare_exchange_weak(last, now, std::memory_order_relaxed)) {}
+                        r->done.arrive_and_wait();
+                        if (cfg.threads > 1)
+                            s.handoffs.push_back(elapsed_us(bench_clock::time_point{ bench_clock::duration{ r->last_arrival.load(std::memory_order_relaxed) } }));
+                        ++s.ops;
+                    }
+                });
+            }
+        });
+        results.push_back({ "latch", cfg, seconds, std::move(stats) });
+    }
+    return results;
+}
+
+struct summary {
+    double mops, jain, min_share, max_share, p50, p90, p99;
+    bool   has_handoff;
+};
+
+summary summarize(const result& r) {
+    double sum = 0, sum_sq = 0, min = 0, max = 0;
+    std::vector<double> all;
+    for (std::size_t i = 0; i < r.stats.size(); ++i) {
+        auto ops = static_cast<double>(r.stats[i].ops);
+        sum += ops;
+        sum_sq += ops * ops;
+        min = i == 0 ? ops : std::min(min, ops);
+        max = std::max(max, ops);
+        all.insert(all.end(), r.stats[i].handoffs.begin(), r.stats[i].handoffs.end());
+    }
+    std::sort(all.begin(), all.end());
+    auto percentile = [&](double q) { return all.empty() ? 0.0 : all[static_cast<std::size_t>(q * static_cast<double>(all.size() - 1))]; };
+    return { sum / r.seconds / 1e6,
+             sum_sq == 0 ? 0.0 : sum * sum / (static_cast<double>(r.stats.size()) * sum_sq),
+             sum == 0 ? 0.0 : min / sum, sum == 0 ? 0.0 : max / sum,
+             percentile(0.5), percentile(0.9), percentile(0.99), !all.empty() };
+}
+
+void print_header(output format) {
+    if (format == output::table)
+        std::cout << std::format("{:>20} {:>7} {:>5} {:>6} {:>10} {:>6} {:>16} {:>8} {:>8} {:>8}\n",
+            "primitive", "threads", "cs", "write%", "Mops/s", "jain", "min/max share", "p50", "p90", "p99");
+    else if (format == output::csv)
+        std::cout << "primitive,threads,cs,write_percent,mops,jain,min_share,max_share,handoff_p50_us,handoff_p90_us,handoff_p99_us\n";
+}
+
+void print(const result& r, output format) {
+    summary s = summarize(r);
+    switch (format) {
+    case output::table: {
+        auto latency = [&](double v) { return s.has_handoff ? std::format("{:.2f}", v) : std::string{ "-" }; };
+        std::cout << std::format("{:>20} {:>7} {:>5} {:>6} {:>10.3f} {:>6.3f} {:>16} {:>8} {:>8} {:>8}\n",
+            r.primitive, r.cfg.threads, r.cfg.cs, r.cfg.write_percent, s.mops, s.jain,
+            std::format("{:.3f}/{:.3f}", s.min_share, s.max_share), latency(s.p50), latency(s.p90), latency(s.p99));
+        break;
+    }
+    case output::csv:
+        std::cout << std::format("{},{},{},{},{:.4f},{:.4f},{:.4f},{:.4f},{},{},{}\n",
+            r.primitive, r.cfg.threads, r.cfg.cs, r.cfg.write_percent, s.mops, s.jain, s.min_share, s.max_share,
+            s.has_handoff ? std::format("{:.3f}", s.p50) : "", s.has_handoff ? std::format("{:.3f}", s.p90) : "",
+            s.has_handoff ? std::format("{:.3f}", s.p99) : "");
+        break;
+    case output::json: {
+        std::string shares;
+        double total = 0;
+        for (const auto& t : r.stats)
+            total += static_cast<double>(t.ops);
+        for (const auto& t : r.stats)
+            shares += std::format("{}{:.4f}", shares.empty() ? "" : ",", total == 0 ? 0.0 : static_cast<double>(t.ops) / total);
+        auto latency = [&](double v) { return s.has_handoff ? std::format("{:.3f}", v) : std::string{ "null" }; };
+        std::cout << std::format("{{\"primitive\":\"{}\",\"threads\":{},\"cs\":{},\"write_percent\":{},\"mops\":{:.4f},"
+            "\"jain\":{:.4f},\"min_share\":{:.4f},\"max_share\":{:.4f},\"handoff_p50_us\":{},\"handoff_p90_us\":{},"
+            "\"handoff_p99_us\":{},\"shares\":[{}]}}\n",
+            r.primitive, r.cfg.threads, r.cfg.cs, r.cfg.write_percent, s.mops, s.jain, s.min_share, s.max_share,
+            latency(s.p50), latency(s.p90), latency(s.p99), shares);
+        break;
+    }
+    }
+    std::cout.flush();
+}
+
+int main(int argc, char* argv[]) {
+    auto thread_counts  = bench_thread_counts(argc, argv);
+    auto cs_list        = bench_parse_list(argc > 2 ? argv[2] : "", { 0, 100, 1000 });
+    auto write_percents = bench_parse_list(argc > 3 ? argv[3] : "", { 10, 50 });
+    std::string_view format_arg = argc > 4 ? argv[4] : "table";
+    output format = format_arg == "csv" ? output::csv : format_arg == "json" ? output::json : output::table;
+
+    print_header(format);
+    for (std::size_t threads : thread_counts) {
+        for (std::size_t cs : cs_list) {
+            config cfg{ threads, static_cast<unsigned>(cs), 100 };
+            for (const auto& r : run_exclusive_primitives(cfg))
+                print(r, format);
+            for (std::size_t write_percent : write_percents) {
+                cfg.write_percent = static_cast<unsigned>(std::min<std::size_t>(write_percent, 100));
+                for (const auto& r : run_read_write_primitives(cfg))
+                    print(r, format);
+            }
+            cfg.write_percent = 100;
+            for (const auto& r : run_phase_primitives(cfg))
+                print(r, format);
+        }
+    }
+}
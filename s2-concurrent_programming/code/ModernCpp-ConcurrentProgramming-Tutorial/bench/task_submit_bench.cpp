@@ -0,0 +1,73 @@
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <format>
+#include <vector>
+#include "../ThreadPool.h"
+#define BENCH_COUNT_ALLOCATIONS // 替换全局 operator new 来统计分配次数
+#include "Bench.h"
+
+// 提交开销：每个任务的堆分配次数和每秒能完成的空任务数
+//   submit : 返回 future，主线程提交完再逐个 get
+//   post   : 发射后不管
+// 用法：task_submit_bench [线程数列表，如 1,2,4,8]
+
+constexpr long num_tasks = 200'000;
+
+struct result {
+    double tasks_per_second;
+    double allocations_per_task;
+};
+
+template<typename F>
+result measure(F&& run) {
+    run(); // 预热：让队列、节点缓存等增长到稳定容量
+    long before = bench_allocations.load();
+    double seconds = bench_seconds(run);
+    return { num_tasks / seconds, double(bench_allocations.load() - before) / num_tasks };
+}
+
+int add(int a, int b) {
+    return a + b;
+}
+
+result run_submit(ThreadPool& pool) {
+    using future_type = decltype(pool.submit(add, 1, 2));
+    std::vector<future_type> futures;
+    futures.reserve(num_tasks);
+    return measure([&] {
+        futures.clear();
+        for (long i = 0; i < num_tasks; ++i)
+            futures.push_back(pool.submit(add, int(i), 1));
+        long sum = 0;
+        for (auto& future : futures)
+            sum += future.get();
+        if (sum == 0)
+            std::abort();
+    });
+}
+
+result run_post(ThreadPool& pool) {
+    return measure([&] {
+        bench_countdown done{ num_tasks };
+        for (long i = 0; i < num_tasks; ++i)
+            pool.post([&done] { done.count_down(); });
+        done.wait();
+    });
+}
+
+int main(int argc, char* argv[]) {
+    std::cout << std::format("{:>8} {:>14} {:>14} {:>12} {:>14} {:>12}\n", "threads", "mode",
+        "submit(Mt/s)", "alloc/task", "post(Mt/s)", "alloc/task");
+    for (std::size_t threads : bench_thread_counts(argc, argv)) {
+        for (auto mode : { ThreadPool::mode::fifo, ThreadPool::mode::work_stealing }) {
+            ThreadPool pool{ threads, mode };
+            result submit = run_submit(pool);
+            result post = run_post(pool);
+            std::cout << std::format("{:>8} {:>14} {:>14.3f} {:>12.3f} {:>14.3f} {:>12.3f}\n", threads,
+                mode == ThreadPool::mode::fifo ? "fifo" : "work_stealing",
+                submit.tasks_per_second / 1e6, submit.allocations_per_task,
+                post.tasks_per_second / 1e6, post.allocations_per_task);
+        }
+    }
+}
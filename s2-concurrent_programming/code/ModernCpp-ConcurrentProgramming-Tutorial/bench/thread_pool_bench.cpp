@@ -0,0 +1,61 @@
+#include <iostream>
+#include <format>
+#include "../ThreadPool.h"
+#include "Bench.h"
+
+// 细粒度任务吞吐量：共享队列（fifo）对比工作窃取（work_stealing）
+//   flat   : 主线程提交大量小任务
+//   nested : 任务在工作线程里继续提交子任务（二叉树展开），典型的分治场景
+// 用法：thread_pool_bench [线程数列表，如 1,2,4,8]
+
+constexpr long     flat_tasks  = 200'000;
+constexpr int      tree_depth  = 14;  // 每棵树 2^15 - 1 个任务
+constexpr int      tree_roots  = 8;
+constexpr unsigned task_work   = 50;  // 每个任务的自旋次数，约几十纳秒
+
+double run_flat(ThreadPool& pool) {
+    bench_countdown done{ flat_tasks };
+    return bench_seconds([&] {
+        for (long i = 0; i < flat_tasks; ++i) {
+            pool.submit([&done] {
+                bench_spin(task_work);
+                done.count_down();
+            });
+        }
+        done.wait();
+    });
+}
+
+void spawn_tree(ThreadPool& pool, bench_countdown& done, int depth) {
+    bench_spin(task_work);
+    if (depth > 0) {
+        pool.submit(spawn_tree, std::ref(pool), std::ref(done), depth - 1);
+        pool.submit(spawn_tree, std::ref(pool), std::ref(done), depth - 1);
+    }
+    done.count_down();
+}
+
+double run_nested(ThreadPool& pool, long& total) {
+    total = tree_roots * ((1L << (tree_depth + 1)) - 1);
+    bench_countdown done{ total };
+    return bench_seconds([&] {
+        for (int i = 0; i < tree_roots; ++i)
+            pool.submit(spawn_tree, std::ref(pool), std::ref(done), tree_depth);
+        done.wait();
+    });
+}
+
+int main(int argc, char* argv[]) {
+    std::cout << std::format("{:>8} {:>14} {:>16} {:>16}\n", "threads", "mode", "flat(Mtask/s)", "nested(Mtask/s)");
+    for (std::size_t threads : bench_thread_counts(argc, argv)) {
+        for (auto mode : { ThreadPool::mode::fifo, ThreadPool::mode::work_stealing }) {
+            ThreadPool pool{ threads, mode };
+            double flat = flat_tasks / run_flat(pool) / 1e6;
+            long nested_tasks = 0;
+            double nested_seconds = run_nested(pool, nested_tasks);
+            double nested = nested_tasks / nested_seconds / 1e6;
+            std::cout << std::format("{:>8} {:>14} {:>16.3f} {:>16.3f}\n", threads,
+                mode == ThreadPool::mode::fifo ? "fifo" : "work_stealing", flat, nested);
+        }
+    }
+}